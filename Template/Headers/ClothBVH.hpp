@@ -0,0 +1,79 @@
+#pragma once
+
+#include <ClothParticles.hpp>
+#include <TriangleBVH.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Centroid bins per axis tried by the SAH build
+#define BVH_SAH_BINS 12
+
+// A refit tree is rebuilt once its SAH cost grows past this multiple of the cost it had when built
+#define BVH_REBUILD_RATIO 1.5f
+
+/// <summary>
+/// Bounding volume hierarchy over the triangles of a deforming cloth, in world space.
+/// Built with the surface area heuristic (SAH) and refit bottom-up as the cloth moves; rebuilt only once
+/// refitting has made the tree noticeably worse than a fresh build would be
+/// </summary>
+class ClothBVH
+{
+public:
+	ClothBVH();
+
+	/// <summary>
+	/// Move the tree to the particles' current positions, placed in the world by modelMatrix.
+	/// Builds the tree on the first call and whenever its quality degraded, refits it otherwise.
+	/// Returns true if the tree was rebuilt
+	/// </summary>
+	bool Update(const ClothParticles& particles, const std::vector<unsigned int>& triIndices, const glm::mat4& modelMatrix);
+
+	bool IsEmpty() const;
+
+	/// <summary>
+	/// Bounds of the whole cloth
+	/// </summary>
+	void GetBounds(glm::vec3& min, glm::vec3& max) const;
+
+	/// <summary>
+	/// SAH cost of the tree: the expected number of nodes visited plus triangles tested by a query,
+	/// measured by surface area relative to the root
+	/// </summary>
+	float GetCost() const;
+
+	/// <summary>
+	/// World space position of particle i as of the last Update()
+	/// </summary>
+	inline glm::vec3 GetPosition(size_t i) const
+	{
+		return m_positions[i];
+	}
+
+	/// <summary>
+	/// Closest point of the cloth surface to point, if it is nearer than maxDistance.
+	/// normal is the face normal of the triangle the closest point lies on, or zero for a collapsed triangle
+	/// </summary>
+	bool ClosestPoint(glm::vec3 point, float maxDistance, glm::vec3& closest, glm::vec3& normal) const;
+
+private:
+	void Build();
+
+	/// <summary>
+	/// Split triangles [first, first + count) at the cheapest of the binned SAH candidates
+	/// </summary>
+	void BuildNode(uint32_t node, uint32_t first, uint32_t count, int depth, const std::vector<glm::vec3>& centroids,
+		std::vector<uint32_t>& order);
+
+	/// <summary>
+	/// Recompute every node's bounds from its triangles or children, children before parents. Returns the new SAH cost
+	/// </summary>
+	float Refit();
+
+	std::vector<BVHNode> m_nodes;					// Root first, children always after their parent
+	std::vector<uint32_t> m_triangles;				// 3 particle indices per triangle, in leaf order
+	std::vector<glm::vec3> m_positions;				// World space position of every particle
+	float m_cost;
+	float m_builtCost;								// SAH cost right after the last build
+};
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <ClothKernels.hpp>
+#include <TriangleBVH.hpp>
+#include <SDFGrid.hpp>
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Particles moved to world space and tested against the colliders together; a multiple of 8
+#define COLLIDER_BLOCK_SIZE 256
+
+// **********************************************************************
+// Collider primitives, all in world space
+// **********************************************************************
+
+struct SphereCollider {
+	glm::vec3 center;
+	float radius;
+};
+
+/// <summary>
+/// Every point within radius of the segment ab
+/// </summary>
+struct CapsuleCollider {
+	glm::vec3 a;
+	glm::vec3 b;
+	float radius;
+};
+
+/// <summary>
+/// Oriented box; the columns of rotation are its unit axes
+/// </summary>
+struct BoxCollider {
+	glm::vec3 center;
+	glm::mat3 rotation;
+	glm::vec3 halfExtents;
+};
+
+/// <summary>
+/// Solid half-space below the plane dot(normal, p) = offset, e.g. the floor. normal has unit length
+/// </summary>
+struct PlaneCollider {
+	glm::vec3 normal;
+	float offset;
+};
+
+/// <summary>
+/// Baked distance field placed in the scene by modelMatrix, which may only rotate, translate and scale uniformly.
+/// The grid is owned elsewhere and has to outlive the Simulate() call
+/// </summary>
+struct SDFCollider {
+	const SDFGrid* grid;
+	glm::mat4 modelMatrix;
+};
+
+/// <summary>
+/// Static triangle mesh placed in the scene by modelMatrix.
+/// The BVH is owned by the mesh and has to outlive the Simulate() call
+/// </summary>
+struct MeshCollider {
+	const TriangleBVH* bvh;
+	glm::mat4 modelMatrix;
+};
+
+inline bool operator==(const SphereCollider& a, const SphereCollider& b)
+{
+	return a.center == b.center && a.radius == b.radius;
+}
+
+inline bool operator==(const CapsuleCollider& a, const CapsuleCollider& b)
+{
+	return a.a == b.a && a.b == b.b && a.radius == b.radius;
+}
+
+inline bool operator==(const BoxCollider& a, const BoxCollider& b)
+{
+	return a.center == b.center && a.rotation == b.rotation && a.halfExtents == b.halfExtents;
+}
+
+inline bool operator==(const PlaneCollider& a, const PlaneCollider& b)
+{
+	return a.normal == b.normal && a.offset == b.offset;
+}
+
+inline bool operator==(const SDFCollider& a, const SDFCollider& b)
+{
+	return a.grid == b.grid && a.modelMatrix == b.modelMatrix;
+}
+
+inline bool operator==(const MeshCollider& a, const MeshCollider& b)
+{
+	return a.bvh == b.bvh && a.modelMatrix == b.modelMatrix;
+}
+
+/// <summary>
+/// Axis aligned bounds of the box [min, max] after a transform
+/// </summary>
+void TransformBounds(const glm::mat4& transform, glm::vec3& min, glm::vec3& max);
+
+/// <summary>
+/// World space bounds of a collider. False for unbounded ones (planes)
+/// </summary>
+bool GetColliderBounds(const SphereCollider& collider, glm::vec3& min, glm::vec3& max);
+bool GetColliderBounds(const CapsuleCollider& collider, glm::vec3& min, glm::vec3& max);
+bool GetColliderBounds(const BoxCollider& collider, glm::vec3& min, glm::vec3& max);
+bool GetColliderBounds(const PlaneCollider& collider, glm::vec3& min, glm::vec3& max);
+bool GetColliderBounds(const SDFCollider& collider, glm::vec3& min, glm::vec3& max);
+bool GetColliderBounds(const MeshCollider& collider, glm::vec3& min, glm::vec3& max);
+
+/// <summary>
+/// Signed distance from point to the surface of a collider, negative inside, and the outward unit normal there.
+/// Exact, so a point can always move that far without touching the collider
+/// </summary>
+float GetColliderDistance(const SphereCollider& collider, glm::vec3 point, glm::vec3& normal);
+float GetColliderDistance(const CapsuleCollider& collider, glm::vec3 point, glm::vec3& normal);
+float GetColliderDistance(const BoxCollider& collider, glm::vec3 point, glm::vec3& normal);
+float GetColliderDistance(const PlaneCollider& collider, glm::vec3 point, glm::vec3& normal);
+
+/// <summary>
+/// Same for a distance field, in world units. Outside the grid this is the distance to the grid's box,
+/// which the surface lies within
+/// </summary>
+float GetSDFDistance(const SDFGrid& grid, const glm::mat4& worldToGrid, const glm::mat4& gridToWorld, float scale, glm::vec3 point, glm::vec3& normal);
+
+/// <summary>
+/// Everything a cloth collides with in one frame
+/// </summary>
+struct ColliderSet {
+	std::vector<SphereCollider> spheres;
+	std::vector<CapsuleCollider> capsules;
+	std::vector<BoxCollider> boxes;
+	std::vector<PlaneCollider> planes;
+	std::vector<SDFCollider> sdfs;
+	std::vector<MeshCollider> meshes;
+
+	bool IsEmpty() const
+	{
+		return spheres.empty() && capsules.empty() && boxes.empty() && planes.empty() && sdfs.empty() && meshes.empty();
+	}
+
+	void Clear()
+	{
+		spheres.clear();
+		capsules.clear();
+		boxes.clear();
+		planes.clear();
+		sdfs.clear();
+		meshes.clear();
+	}
+};
+
+// **********************************************************************
+// Block kernels: push the points of a block that are closer than margin to a primitive, or inside it,
+// out to margin. Branch-free over the block, so one call handles all its points
+// **********************************************************************
+
+/// <summary>
+/// World space positions of up to COLLIDER_BLOCK_SIZE particles. Lanes past the last particle repeat it,
+/// so kernels always work on whole groups of 8
+/// </summary>
+struct ColliderBlock {
+	alignas(32) float x[COLLIDER_BLOCK_SIZE];
+	alignas(32) float y[COLLIDER_BLOCK_SIZE];
+	alignas(32) float z[COLLIDER_BLOCK_SIZE];
+	size_t count;								// Lanes in use, a multiple of 8
+};
+
+struct ColliderKernels {
+	void (*sphere)(ColliderBlock& block, const SphereCollider& sphere, float margin);
+	void (*capsule)(ColliderBlock& block, const CapsuleCollider& capsule, float margin);
+	void (*box)(ColliderBlock& block, const BoxCollider& box, float margin);
+	void (*plane)(ColliderBlock& block, const PlaneCollider& plane, float margin);
+	const char* name;
+};
+
+void CollideSphereScalar(ColliderBlock& block, const SphereCollider& sphere, float margin);
+void CollideCapsuleScalar(ColliderBlock& block, const CapsuleCollider& capsule, float margin);
+void CollideBoxScalar(ColliderBlock& block, const BoxCollider& box, float margin);
+void CollidePlaneScalar(ColliderBlock& block, const PlaneCollider& plane, float margin);
+
+#ifdef CLOTH_KERNELS_X86
+// 8 points per instruction, needs AVX2 and FMA
+void CollideSphereAVX2(ColliderBlock& block, const SphereCollider& sphere, float margin);
+void CollideCapsuleAVX2(ColliderBlock& block, const CapsuleCollider& capsule, float margin);
+void CollideBoxAVX2(ColliderBlock& block, const BoxCollider& box, float margin);
+void CollidePlaneAVX2(ColliderBlock& block, const PlaneCollider& plane, float margin);
+
+const ColliderKernels& GetAVX2ColliderKernels();
+#endif
+
+/// <summary>
+/// Widest collider kernels the running CPU supports, AVX2 whenever the AVX2 integration kernel is used
+/// </summary>
+const ColliderKernels& SelectColliderKernels();
+
+const ColliderKernels& GetScalarColliderKernels();
+
+/// <summary>
+/// Distance field counterpart of the kernels. Samples are gathered point by point, so it stays scalar;
+/// worldToGrid and scale come from the collider's modelMatrix
+/// </summary>
+void CollideSDF(ColliderBlock& block, const SDFGrid& grid, const glm::mat4& worldToGrid, const glm::mat4& gridToWorld, float scale, float margin);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <ClothParticles.hpp>
+#include <ClothKernels.hpp>
+#include <ClothSolverSettings.hpp>
+#include <ThreadPool.hpp>
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Floats per chunk of the conjugate gradient vector work. Dot products are summed chunk by chunk in order,
+// so the result doesn't depend on how chunks are spread over threads
+#define CG_CHUNK_SIZE 4096
+
+// Block rows per task when assembling or multiplying the system
+#define MIN_BLOCK_ROWS_PER_TASK 256
+
+/// <summary>
+/// Square matrix of 3x3 blocks in block compressed sparse row (BSR) form
+/// </summary>
+struct BlockSparseMatrix {
+	std::vector<size_t> rowStart;			// Block row r holds blocks [rowStart[r], rowStart[r + 1]), its diagonal block first
+	std::vector<unsigned int> columns;		// Block column of every block
+	std::vector<glm::mat3> blocks;
+
+	inline size_t GetRowCount() const
+	{
+		return rowStart.empty() ? 0 : rowStart.size() - 1;
+	}
+
+	/// <summary>
+	/// y = A x, for x and y of 3 floats per block row. Rows are spread over the pool
+	/// </summary>
+	void Multiply(const float* x, float* y, ThreadPool& pool) const;
+};
+
+/// <summary>
+/// Backward Euler step of a cloth grid held together by springs, after Baraff and Witkin: stretch springs along every
+/// grid edge, shear springs across both diagonals of every quad. The forces are linearised around the current positions
+/// into a block sparse system for the velocity change, (M - h^2 df/dx + h c M) dv = h (f + h df/dx v), which is solved
+/// with conjugate gradients preconditioned by the inverse diagonal. Being implicit, one step per frame stays stable however stiff the springs
+/// </summary>
+class ClothImplicit
+{
+public:
+	ClothImplicit();
+
+	/// <summary>
+	/// Springs between grid neighbours at their distance in particles, and the matrix pattern they give
+	/// </summary>
+	void Build(const ClothParticles& particles, unsigned int gridRes);
+
+	/// <summary>
+	/// Advance the particles by one step of length h, with the velocity x - prev covering one such step.
+	/// terms hold the external accelerations and drag per unit of time; springs and iteration limits come from settings.
+	/// Particles with an inverse mass of 0 stay put. Returns the conjugate gradient iterations run
+	/// </summary>
+	int Step(ClothParticles& particles, const IntegrationTerms& terms, float h, const ClothSolverSettings& settings, ThreadPool& pool);
+
+	/// <summary>
+	/// Preconditioned residual of the last Step() relative to its start, sqrt(r . z / r0 . z0)
+	/// </summary>
+	float GetResidual() const;
+
+private:
+	/// <summary>
+	/// Linearise the springs around the current positions into m_matrix and m_rhs, with a first guess in m_deltaV.
+	/// Rows of particles that can't move become identity rows
+	/// </summary>
+	void Assemble(const ClothParticles& particles, const IntegrationTerms& terms, float h, const ClothSolverSettings& settings, ThreadPool& pool);
+
+	/// <summary>
+	/// Solve m_matrix m_deltaV = m_rhs, starting from what m_deltaV holds. Returns the iterations run
+	/// </summary>
+	int SolveConjugateGradient(int maxIterations, float tolerance, ThreadPool& pool);
+
+	/// <summary>
+	/// Run kernel over every CG_CHUNK_SIZE chunk of the system's floats and sum what it returns in chunk order
+	/// </summary>
+	template <typename Kernel>
+	float ReduceChunks(const Kernel& kernel, ThreadPool& pool);
+
+	const ConjugateGradientKernels& m_kernels;
+	float m_residual;
+
+	BlockSparseMatrix m_matrix;
+	std::vector<float> m_restLengths;		// Rest length of the spring behind every off-diagonal block, 0 on the diagonal
+	std::vector<uint8_t> m_shear;			// Whether that spring is a shear spring
+
+	// 3 floats per particle
+	AlignedFloats m_velocity;				// At the start of the step
+	AlignedFloats m_rhs;
+	AlignedFloats m_deltaV;
+	AlignedFloats m_residualVector;
+	AlignedFloats m_preconditioned;
+	AlignedFloats m_direction;
+	AlignedFloats m_product;
+	AlignedFloats m_invDiagonal;
+	std::vector<float> m_partials;			// Per chunk partial sums
+};
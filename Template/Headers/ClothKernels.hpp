@@ -0,0 +1,215 @@
+#pragma once
+
+#include <ClothParticles.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <math.h>
+#include <glm/glm.hpp>
+
+/// <summary>
+/// External terms applied by one Verlet integration sweep:
+/// x' = x + (x - prev) * (1 - damping) + acceleration + windDirection(i) * wind
+/// </summary>
+struct IntegrationTerms {
+	glm::vec3 acceleration = glm::vec3(0.0f);	// Displacement added per step, e.g. gravity * dt
+	float damping = 0.0f;						// Fraction of the velocity removed, e.g. drag * dt
+	float wind = 0.0f;							// Length of the per-particle random push, e.g. wind * dt
+	uint32_t windSeed = 0;						// Changes the wind pattern between sweeps
+};
+
+/// <summary>
+/// Raw arrays of a ClothParticles. Kernel files built with their own instruction sets work on these, so they call no
+/// inline code from other headers that the linker could share with the rest of the program
+/// </summary>
+struct ParticleArrays {
+	float *x, *y, *z;
+	float *prevX, *prevY, *prevZ;
+	const float* invMass;
+};
+
+ParticleArrays GetParticleArrays(ClothParticles& particles);
+
+/// <summary>
+/// Integrates particles [begin, end) in place; pinned particles (inverse mass 0) are left alone.
+/// Returns false if any integrated position became non-finite
+/// </summary>
+typedef bool (*IntegrationKernel)(ClothParticles& particles, size_t begin, size_t end, const IntegrationTerms& terms);
+
+bool IntegrateScalar(ClothParticles& particles, size_t begin, size_t end, const IntegrationTerms& terms);
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CLOTH_KERNELS_X86
+
+// 4 particles per instruction, needs SSE4.1
+bool IntegrateSSE(ClothParticles& particles, size_t begin, size_t end, const IntegrationTerms& terms);
+
+// 8 particles per instruction, needs AVX2 and FMA
+bool IntegrateAVX2(ClothParticles& particles, size_t begin, size_t end, const IntegrationTerms& terms);
+
+/// <summary>
+/// Whether the running CPU and OS can run the AVX2 + FMA kernels, or with avx2 false the SSE4.1 ones
+/// </summary>
+bool CpuSupports(bool avx2);
+#endif
+
+/// <summary>
+/// Widest integration kernel the running CPU supports, detected once
+/// </summary>
+IntegrationKernel SelectIntegrationKernel();
+
+const char* GetIntegrationKernelName(IntegrationKernel kernel);
+
+// **********************************************************************
+// Jacobi constraint sweeps
+// **********************************************************************
+
+/// <summary>
+/// Inputs and outputs of one Jacobi sweep over the cloth grid. Every particle gathers the corrections of its four links
+/// from the positions the sweep starts at, averages them over the links that pulled and writes the result to out:
+/// out = last + omega * (x + sum / pulled - last)
+/// </summary>
+struct JacobiTerms {
+	const float *x, *y, *z;							// Positions the sweep starts from
+	const float *lastX, *lastY, *lastZ;				// Positions the sweep before started from, for the Chebyshev step
+	const float* invMass;
+	const float *restLeft, *restRight;				// Rest length of each particle's link to its neighbour in the row, 0 if it has none
+	const float *restUp, *restDown;					// Same for the rows before and after
+	float *outX, *outY, *outZ;
+	unsigned int gridRes;
+	float slack;
+	float omega;									// Chebyshev weight, 1 is a plain Jacobi sweep
+};
+
+/// <summary>
+/// Sweeps row of the grid; particles that can't move are copied. Returns the largest relative stretch of the row's links
+/// </summary>
+typedef float (*JacobiKernel)(const JacobiTerms& terms, size_t row);
+
+float JacobiScalar(const JacobiTerms& terms, size_t row);
+
+#ifdef CLOTH_KERNELS_X86
+// 8 particles per instruction, needs AVX2 and FMA
+float JacobiAVX2(const JacobiTerms& terms, size_t row);
+#endif
+
+/// <summary>
+/// Widest Jacobi kernel the running CPU supports
+/// </summary>
+JacobiKernel SelectJacobiKernel();
+
+const char* GetJacobiKernelName(JacobiKernel kernel);
+
+/// <summary>
+/// Jacobi sweep of particle i, whose neighbours are left, right, up and down (any index where it has no link).
+/// The reference for the SIMD kernels, which also use it for the row ends. Static, so every kernel file keeps its own copy
+/// built with its own instruction set
+/// </summary>
+static inline float JacobiParticle(const JacobiTerms& terms, size_t i, size_t left, size_t right, size_t up, size_t down)
+{
+	const float w = terms.invMass[i];
+	const float px = terms.x[i], py = terms.y[i], pz = terms.z[i];
+
+	if (w == 0.0f)
+	{
+		terms.outX[i] = px;
+		terms.outY[i] = py;
+		terms.outZ[i] = pz;
+		return 0.0f;
+	}
+
+	const size_t neighbours[4] = { left, right, up, down };
+	const float restLengths[4] = { terms.restLeft[i], terms.restRight[i], terms.restUp[i], terms.restDown[i] };
+
+	float sumX = 0.0f, sumY = 0.0f, sumZ = 0.0f, pulled = 0.0f, stretch = 0.0f;
+	for (int link = 0; link < 4; link++)
+	{
+		const size_t j = neighbours[link];
+		const float dx = terms.x[j] - px, dy = terms.y[j] - py, dz = terms.z[j] - pz;
+		const float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+		const float restLength = restLengths[link] * terms.slack;
+
+		// Also false for missing links, whose rest length is 0, and non-finite distances
+		if (restLength > 0.0f && distance > restLength && distance < INFINITY)
+		{
+			// This particle's share of pulling the link exactly back to its rest length
+			const float scale = (1.0f - restLength / distance) * (w / (w + terms.invMass[j]));
+			sumX += dx * scale;
+			sumY += dy * scale;
+			sumZ += dz * scale;
+			pulled += 1.0f;
+			stretch = fmaxf(stretch, distance / restLength - 1.0f);
+		}
+	}
+
+	const float average = pulled > 0.0f ? 1.0f / pulled : 0.0f;
+	const float jacobiX = px + sumX * average, jacobiY = py + sumY * average, jacobiZ = pz + sumZ * average;
+
+	const float lastX = terms.lastX[i], lastY = terms.lastY[i], lastZ = terms.lastZ[i];
+	terms.outX[i] = lastX + terms.omega * (jacobiX - lastX);
+	terms.outY[i] = lastY + terms.omega * (jacobiY - lastY);
+	terms.outZ[i] = lastZ + terms.omega * (jacobiZ - lastZ);
+
+	return stretch;
+}
+
+// **********************************************************************
+// Conjugate gradient vector operations
+// **********************************************************************
+
+/// <summary>
+/// The vector work of one preconditioned conjugate gradient iteration, over count floats of each array.
+/// Callers split the arrays into fixed chunks and sum the partial dot products in chunk order, so results don't depend on threads
+/// </summary>
+struct ConjugateGradientKernels {
+	// Returns a . b
+	float (*dot)(const float* a, const float* b, size_t count);
+	// x += alpha * p, r -= alpha * q, z = invDiagonal * r; returns r . z
+	float (*step)(float* x, float* r, float* z, const float* p, const float* q, const float* invDiagonal, float alpha, size_t count);
+	// p = z + beta * p
+	void (*direction)(float* p, const float* z, float beta, size_t count);
+	const char* name;
+};
+
+float DotScalar(const float* a, const float* b, size_t count);
+float ConjugateGradientStepScalar(float* x, float* r, float* z, const float* p, const float* q, const float* invDiagonal, float alpha, size_t count);
+void ConjugateGradientDirectionScalar(float* p, const float* z, float beta, size_t count);
+
+#ifdef CLOTH_KERNELS_X86
+// 8 floats per instruction, needs AVX2 and FMA
+float DotAVX2(const float* a, const float* b, size_t count);
+float ConjugateGradientStepAVX2(float* x, float* r, float* z, const float* p, const float* q, const float* invDiagonal, float alpha, size_t count);
+void ConjugateGradientDirectionAVX2(float* p, const float* z, float beta, size_t count);
+
+const ConjugateGradientKernels& GetAVX2ConjugateGradientKernels();
+#endif
+
+/// <summary>
+/// Widest conjugate gradient kernels the running CPU supports
+/// </summary>
+const ConjugateGradientKernels& SelectConjugateGradientKernels();
+
+const ConjugateGradientKernels& GetScalarConjugateGradientKernels();
+
+// **********************************************************************
+// Wind noise, shared by all kernels so they produce the same directions;
+// static, so each kernel file keeps a copy built with its own instruction set
+// **********************************************************************
+
+static inline uint32_t WindHash(uint32_t h)
+{
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return h;
+}
+
+/// <summary>
+/// Pseudo-random component in [-1, 1) for particle i: 24 hash bits scaled by 2^-23
+/// </summary>
+static inline float WindComponent(uint32_t i, uint32_t seed, uint32_t component)
+{
+	const uint32_t h = WindHash(i * 3u + component + seed * 0x9E3779B1u);
+	return static_cast<float>(static_cast<int32_t>(h >> 8)) * (1.0f / 8388608.0f) - 1.0f;
+}
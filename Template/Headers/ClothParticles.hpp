@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <glm/glm.hpp>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+// Particle arrays start on a cache line and are padded to a whole number of SIMD registers
+const size_t PARTICLE_ALIGNMENT = 64;
+const size_t PARTICLE_LANES = 8;
+
+/// <summary>
+/// Minimal allocator returning PARTICLE_ALIGNMENT aligned storage for std::vector
+/// </summary>
+template <typename T>
+struct AlignedAllocator {
+	typedef T value_type;
+
+	AlignedAllocator() {}
+
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U>&) {}
+
+	T* allocate(size_t n)
+	{
+		const size_t bytes = ((n * sizeof(T) + PARTICLE_ALIGNMENT - 1) / PARTICLE_ALIGNMENT) * PARTICLE_ALIGNMENT;
+#ifdef _MSC_VER
+		void* ptr = _aligned_malloc(bytes, PARTICLE_ALIGNMENT);
+#else
+		void* ptr = std::aligned_alloc(PARTICLE_ALIGNMENT, bytes);
+#endif
+		if (ptr == nullptr)
+			throw std::bad_alloc();
+
+		return static_cast<T*>(ptr);
+	}
+
+	void deallocate(T* ptr, size_t)
+	{
+#ifdef _MSC_VER
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+
+	template <typename U>
+	bool operator==(const AlignedAllocator<U>&) const { return true; }
+
+	template <typename U>
+	bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+typedef std::vector<float, AlignedAllocator<float>> AlignedFloats;
+
+/// <summary>
+/// Structure-of-arrays particle storage used by the solver hot loops.
+/// Arrays hold paddedCount entries; the padding has an inverse mass of 0, so kernels can run over whole registers
+/// </summary>
+struct ClothParticles {
+	AlignedFloats x, y, z;
+	AlignedFloats prevX, prevY, prevZ;
+	AlignedFloats invMass;
+	size_t count = 0;
+	size_t paddedCount = 0;
+
+	void Resize(size_t n)
+	{
+		count = n;
+		paddedCount = ((n + PARTICLE_LANES - 1) / PARTICLE_LANES) * PARTICLE_LANES;
+
+		x.assign(paddedCount, 0.0f);
+		y.assign(paddedCount, 0.0f);
+		z.assign(paddedCount, 0.0f);
+		prevX.assign(paddedCount, 0.0f);
+		prevY.assign(paddedCount, 0.0f);
+		prevZ.assign(paddedCount, 0.0f);
+		invMass.assign(paddedCount, 0.0f);
+	}
+
+	inline glm::vec3 GetPosition(size_t i) const
+	{
+		return glm::vec3(x[i], y[i], z[i]);
+	}
+
+	inline void SetPosition(size_t i, const glm::vec3& pos)
+	{
+		x[i] = pos.x;
+		y[i] = pos.y;
+		z[i] = pos.z;
+	}
+
+	inline glm::vec3 GetPrevPosition(size_t i) const
+	{
+		return glm::vec3(prevX[i], prevY[i], prevZ[i]);
+	}
+
+	inline void SetPrevPosition(size_t i, const glm::vec3& pos)
+	{
+		prevX[i] = pos.x;
+		prevY[i] = pos.y;
+		prevZ[i] = pos.z;
+	}
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <Shader.hpp>
+#include <ClothSolver.hpp>
+#include <string>
+#include <vector>
+
+// Copies of the positions the stream cycles through: one written by the CPU while the GPU may still read the other two
+#define CLOTH_STREAM_FRAMES 3
+
+/// <summary>
+/// Owns the OpenGL objects of a cloth and uploads the solver's particles to them.
+/// Holds no simulation state of its own. Positions and normals are streamed through a persistently mapped ring of
+/// CLOTH_STREAM_FRAMES copies guarded by fences; texture coordinates and indices are immutable.
+/// Without buffer storage (GL 4.4 or ARB_buffer_storage) a single buffer is updated in place instead
+/// </summary>
+class ClothRenderer
+{
+public:
+	unsigned int VAO, streamVBO, texCoordVBO, EBO;
+	unsigned int textureId;
+
+	ClothRenderer(const ClothSolver& solver, std::string textureFile = "clothTexture.jpg");
+
+	~ClothRenderer();
+
+	/// <summary>
+	/// Upload the current particle positions of the solver and their normals
+	/// </summary>
+	void UpdateVertices(const ClothSolver& solver);
+
+	/// <summary>
+	/// Upload positions and normals given by the caller, one per particle, e.g. blended between two steps
+	/// </summary>
+	void UpdateVertices(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals);
+
+	void Render(Shader& shader, glm::mat4 model);
+
+private:
+	void GatherPositions(const ClothSolver& solver);
+
+	/// <summary>
+	/// Where the next vertices go, positions followed by normals: the oldest copy of the ring once the GPU is done with it,
+	/// or m_staging
+	/// </summary>
+	glm::vec3* BeginUpload();
+
+	/// <summary>
+	/// Point the VAO at the copy just written, or upload m_staging
+	/// </summary>
+	void EndUpload();
+
+	unsigned int TextureFromFile(const char* path, bool gamma);
+
+	size_t m_indexCount;
+	size_t m_vertexCount;
+	std::vector<glm::vec3> m_positions, m_normals;		// Gathered from the solver
+	std::vector<glm::vec3> m_staging;					// Positions and normals for the fallback without a mapped ring
+
+	glm::vec3* m_mapped;								// Persistently mapped ring, nullptr in the fallback
+	GLsync m_fences[CLOTH_STREAM_FRAMES];				// Issued after the last draws reading each copy
+	int m_slot;											// Copy the VAO points at
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <ClothParticles.hpp>
+#include <ThreadPool.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#define MIN_COLLISION_PARTICLES_PER_TASK 1024
+
+/// <summary>
+/// Self-collision of one cloth: a uniform spatial hash over its particles, bucketed with a counting sort,
+/// and a Jacobi pass that pushes apart particles closer than the cloth thickness
+/// </summary>
+class ClothSelfCollision
+{
+public:
+	ClothSelfCollision();
+
+	/// <summary>
+	/// Separate every pair of particles closer than thickness, except direct grid neighbours (the 1-ring),
+	/// whose distance is up to the distance constraints. Returns the number of contacts found,
+	/// counted once from each particle that can move
+	/// </summary>
+	size_t Solve(ClothParticles& particles, unsigned int gridRes, float thickness, ThreadPool& pool);
+
+	/// <summary>
+	/// True if the last Solve() had to rebuild the buckets because a particle changed cell
+	/// </summary>
+	bool WasRebuilt() const;
+
+private:
+	/// <summary>
+	/// Hash every particle's cell; rebuild the sorted buckets only if any particle changed cell
+	/// </summary>
+	void UpdateBuckets(const ClothParticles& particles, ThreadPool& pool);
+
+	// Cell key: the three coordinates multiplied by large primes and xor-ed; the low bits pick the bucket
+	static inline uint32_t HashX(int x) { return static_cast<uint32_t>(x) * 73856093u; }
+	static inline uint32_t HashY(int y) { return static_cast<uint32_t>(y) * 19349663u; }
+	static inline uint32_t HashZ(int z) { return static_cast<uint32_t>(z) * 83492791u; }
+
+	inline glm::ivec3 GetCell(glm::vec3 position) const
+	{
+		return glm::ivec3(glm::floor(position * m_inverseCellSize));
+	}
+
+	float m_cellSize, m_inverseCellSize;
+	uint32_t m_bucketMask;							// Bucket count - 1, a power of two
+	bool m_rebuilt;
+
+	std::vector<uint32_t> m_particleKeys;			// Cell key of every particle at the last rebuild
+	std::vector<uint32_t> m_bucketStart;			// Bucket b holds entries [m_bucketStart[b], m_bucketStart[b + 1])
+	std::vector<uint32_t> m_bucketParticles;		// Particle index of every entry, sorted by bucket
+	std::vector<uint32_t> m_bucketKeys;				// Cell key of every entry, tells apart cells sharing a bucket
+	std::vector<uint32_t> m_bucketFill;				// Scatter cursors of the counting sort
+
+	std::vector<glm::vec3> m_deltas;				// Summed push of every particle, applied after all pairs were visited
+	std::vector<uint32_t> m_contacts;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <ClothWorld.hpp>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// <summary>
+/// Everything a ClothWorld::Advance() call needs, copied so the render thread can move on.
+/// The meshes and distance fields the colliders point to must not change while a job runs
+/// </summary>
+struct ClothSimJob {
+	std::vector<ForceField> forceFields;
+	ColliderSet colliders;
+	std::vector<glm::mat4> modelMatrices;
+	float frameTime = 0.0f;
+	float rate = 60.0f;
+	int maxSteps = 4;
+	bool interpolate = true;
+};
+
+/// <summary>
+/// Results of a finished job, ready to render
+/// </summary>
+struct ClothSimFrame {
+	std::vector<std::vector<glm::vec3>> positions;		// Per cloth, blended between the last two steps
+	std::vector<std::vector<glm::vec3>> normals;		// Per cloth, smooth vertex normals of the blended positions
+	ClothSolverStats stats;
+	int steps = 0;
+};
+
+/// <summary>
+/// Steps a ClothWorld on its own thread, so simulating the next frame overlaps with rendering the last one.
+/// Results go to the back of two ClothSimFrames; Sync() waits for the job in flight and swaps them.
+/// Between Sync() and Submit() the worker leaves the world alone, so cloths and their settings can be changed
+/// </summary>
+class ClothSimThread
+{
+public:
+	explicit ClothSimThread(ClothWorld& world);
+
+	/// <summary>
+	/// Finishes the job in flight, if any
+	/// </summary>
+	~ClothSimThread();
+
+	/// <summary>
+	/// Start simulating job. Only one job runs at a time: call Sync() first
+	/// </summary>
+	void Submit(const ClothSimJob& job);
+
+	/// <summary>
+	/// Wait for the job in flight, if any, and return its results. An exception thrown by the job is rethrown here.
+	/// The frame stays valid until the next Sync() call; before the first job finishes it has no positions
+	/// </summary>
+	const ClothSimFrame& Sync();
+
+private:
+	void WorkerLoop();
+
+	ClothWorld& m_world;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	ClothSimJob m_job;
+	bool m_busy;						// A job was submitted and hasn't finished
+	bool m_pending;						// A job was submitted and Sync() hasn't swapped in its frame yet
+	bool m_quit;
+	std::exception_ptr m_error;
+
+	ClothSimFrame m_frames[2];
+	int m_front;						// Frame handed out by Sync(); the worker writes the other one
+
+	std::thread m_thread;				// Last, so everything it uses exists before it starts
+};
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <ExtraMath.hpp>
+#include <ClothParticles.hpp>
+#include <ClothKernels.hpp>
+#include <ThreadPool.hpp>
+#include <ClothSolverSettings.hpp>
+#include <ClothSelfCollision.hpp>
+#include <ClothImplicit.hpp>
+#include <ClothColliders.hpp>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Independent edge batches of the 4-neighbour grid, and the smallest share of a batch worth a thread
+#define CONSTRAINT_COLOURS 4
+#define MIN_CONSTRAINTS_PER_TASK 256
+#define MIN_PARTICLES_PER_TASK 4096
+
+// Particles are put to sleep in square tiles of the grid
+#define SLEEP_TILE_SIZE 8
+
+// Multigrid: coarse levels are built until one has at most this many grid lines across
+#define MULTIGRID_COARSEST_LINES 4
+
+// Jacobi: plain sweeps before the Chebyshev acceleration kicks in
+#define JACOBI_CHEBYSHEV_DELAY 2
+
+// XPBD and implicit modes split a frame into substeps of equal time; at this many their forces match the Gauss-Seidel mode's
+#define XPBD_REFERENCE_SUBSTEPS 3
+
+// Continuous collision: most sphere tracing steps per collider, and how close to the margin (world units) counts as touching
+#define SWEEP_ITERATIONS 16
+#define SWEEP_TOLERANCE 1e-4f
+
+/// <summary>
+/// Distance constraint between particles i and j of the cloth grid
+/// </summary>
+struct DistanceConstraint {
+	unsigned int i, j;
+	float restLength;		// Unstretched length, the solver's slack is applied on top
+};
+
+/// <summary>
+/// Long range attachment: particle may get no further from the pinned anchor than the distance between them across the cloth
+/// </summary>
+struct Tether {
+	unsigned int particle, anchor;
+	float restLength;		// Geodesic distance at rest, the solver's slack is applied on top
+};
+
+enum class ForceFieldType
+{
+	CONSTANT,
+	DRAG,
+	WIND
+};
+
+/// <summary>
+/// External force acting on every free particle of the cloth
+/// </summary>
+struct ForceField {
+	ForceFieldType type;
+	glm::vec3 acceleration;		// CONSTANT: acceleration added every step
+	float amount;				// DRAG: drag coefficient, WIND: strength of the random gusts
+
+	static ForceField Constant(glm::vec3 acceleration)
+	{
+		return ForceField{ ForceFieldType::CONSTANT, acceleration, 0.0f };
+	}
+
+	static ForceField Drag(float drag)
+	{
+		return ForceField{ ForceFieldType::DRAG, glm::vec3(0.0f), drag };
+	}
+
+	static ForceField Wind(float wind)
+	{
+		return ForceField{ ForceFieldType::WIND, glm::vec3(0.0f), wind };
+	}
+};
+
+/// <summary>
+/// Contiguous run of particle indices [begin, end)
+/// </summary>
+struct ParticleRange {
+	size_t begin, end;
+};
+
+/// <summary>
+/// CPU-only cloth state (particles, rest lengths) and the Verlet/constraint solver.
+/// Has no OpenGL dependency, so it builds into the headless ClothSolver library
+/// </summary>
+class ClothSolver
+{
+public:
+	float width, depth, widthStep, depthStep, dU, dV;
+	ClothParticles particles;
+	std::vector<glm::vec2> texCoords;							// Static, only used for rendering
+	std::vector<unsigned int> indices, triIndices;
+	std::vector<DistanceConstraint> constraints;				// Every grid edge, built once at construction
+	std::vector<size_t> constraintBatches;						// Colour c covers [constraintBatches[c], constraintBatches[c + 1])
+	std::vector<Tether> tethers;								// One per free particle to its nearest pinned one, built once
+	unsigned int gridRes;
+	ClothSolverSettings settings;
+
+	ClothSolver(float width, float depth, unsigned int wP, unsigned int dP, unsigned int gridRes, float initHeight = 2.0f,
+		const ClothSolverSettings& settings = ClothSolverSettings(), ThreadPool& pool = ThreadPool::Default());
+
+	/// <summary>
+	/// Integrate gravity and all force fields in a single Verlet sweep. substepScale is the length of the substep
+	/// relative to the one the forces are tuned for: accelerations scale with its square, drag with it
+	/// </summary>
+	void ApplyForces(const std::vector<ForceField>& forceFields, float dt, float substepScale = 1.0f);
+
+	/// <summary>
+	/// Solve the distance constraints with settings.solverMode until the largest relative stretch a sweep measures
+	/// drops below settings.tolerance, or settings.constraintIterations sweeps are done. Returns the sweeps run.
+	/// dt is the substep's share of the frame. The result doesn't depend on the thread count
+	/// </summary>
+	int ApplyConstraints(float dt);
+
+	/// <summary>
+	/// Push particles that are within settings.colliderMargin of a collider, or inside it, out to the margin.
+	/// modelMatrix places the cloth in the scene
+	/// </summary>
+	void Collide(const ColliderSet& colliders, const glm::mat4& modelMatrix);
+
+	/// <summary>
+	/// Advance the cloth by one frame of settings.substeps substeps
+	/// </summary>
+	void Simulate(const std::vector<ForceField>& forceFields, const ColliderSet& colliders, glm::mat4 modelMatrix, float dt);
+
+	/// <summary>
+	/// The pieces of Simulate(), for callers that need to step in between substeps:
+	/// BeginFrame(), settings.substeps times Substep(), then EndFrame()
+	/// </summary>
+	void BeginFrame(const std::vector<ForceField>& forceFields, const ColliderSet& colliders, const glm::mat4& modelMatrix);
+
+	void Substep(const std::vector<ForceField>& forceFields, const ColliderSet& colliders, const glm::mat4& modelMatrix, float dt);
+
+	void EndFrame();
+
+	/// <summary>
+	/// Wake every sleeping tile, e.g. after the cloth was moved by hand
+	/// </summary>
+	void WakeAll();
+
+	/// <summary>
+	/// Wake the tiles overlapping an axis aligned box in cloth space; meant for colliders moving into the cloth
+	/// </summary>
+	void WakeRegion(glm::vec3 min, glm::vec3 max);
+
+	/// <summary>
+	/// Smooth vertex normals of the grid at positions, one per particle: the area weighted normals of the triangles around
+	/// each vertex. Every vertex gathers from its own neighbourhood, so rows are spread over the thread pool without atomics
+	/// </summary>
+	void ComputeNormals(const std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals) const;
+
+	/// <summary>
+	/// Constraint statistics of the last Simulate() call
+	/// </summary>
+	inline ClothSolverStats GetStats() const
+	{
+		return m_stats;
+	}
+
+private:
+	void AddConstraint(std::vector<DistanceConstraint>& batch, unsigned int i, unsigned int j);
+
+	/// <summary>
+	/// Tie every free particle to the pinned particle nearest to it across the rest shape of the cloth
+	/// </summary>
+	void BuildTethers();
+
+	/// <summary>
+	/// Pull particles that strayed further from their anchor than the tether allows straight back onto its sphere.
+	/// Anchors never move, so every tether is independent
+	/// </summary>
+	void ApplyTethers();
+
+	/// <summary>
+	/// Gauss-Seidel sweeps, each colour batch spread over the thread pool
+	/// </summary>
+	int SolveGaussSeidel();
+
+	/// <summary>
+	/// XPBD sweeps in the same colour order: each link accumulates its Lagrange multiplier over the substep,
+	/// with compliance scaled by the squared substep time, so the result converges to the same stiffness whatever the sweep count
+	/// </summary>
+	int SolveXPBD(float dt);
+
+	/// <summary>
+	/// Jacobi sweeps: every particle gathers the corrections of its links from the positions the sweep starts at,
+	/// so rows run in parallel without colours and the result is the same bit for bit whatever the thread count.
+	/// Chebyshev acceleration with settings.chebyshevRho makes up for the slower convergence
+	/// </summary>
+	int SolveJacobi();
+
+	/// <summary>
+	/// Per-particle rest lengths of the four grid links, from the constraint table
+	/// </summary>
+	void BuildJacobiLinks();
+
+	/// <summary>
+	/// V-cycles over coarser copies of the grid: each coarse level, from the coarsest up, is swept and its correction
+	/// interpolated onto the particles only the next finer level has, then the fine grid is swept. The coarse links
+	/// pull the whole cloth together at once, so the sweeps needed stay about the same as the grid gets finer
+	/// </summary>
+	int SolveMultigrid();
+
+	/// <summary>
+	/// Build the coarse levels, every other grid line of the level below plus its last one, and their links
+	/// </summary>
+	void BuildMultigrid();
+
+	/// <summary>
+	/// Add the correction of level's particles since the V-cycle began, interpolated bilinearly,
+	/// to the particles of the next finer level that aren't on level
+	/// </summary>
+	void ProlongCorrection(size_t level);
+
+	/// <summary>
+	/// One sweep over constraints, colour by colour. Returns the largest relative stretch found
+	/// </summary>
+	float SweepConstraints(const std::vector<DistanceConstraint>& batchedConstraints, const std::vector<size_t>& batches, float slack);
+
+	/// <summary>
+	/// Length of a substep relative to the one forces are tuned for. Only XPBD and implicit split the frame, the other modes give 1
+	/// </summary>
+	float GetSubstepScale() const;
+
+	/// <summary>
+	/// Keep velocities, stored as the distance moved per substep, when the substep length changes
+	/// </summary>
+	void RescaleVelocities(float scale);
+
+	/// <summary>
+	/// Sum gravity and the force fields into the external terms of one step; see ApplyForces()
+	/// </summary>
+	IntegrationTerms GatherForces(const std::vector<ForceField>& forceFields, float dt, float substepScale);
+
+	/// <summary>
+	/// Run one integration sweep over all particles with the selected SIMD kernel
+	/// </summary>
+	void Integrate(const IntegrationTerms& terms, const char* issue);
+
+	/// <summary>
+	/// Once per frame: let tiles that rested for settings.sleepFrames fall asleep, and wake tiles next to moving ones
+	/// </summary>
+	void UpdateSleep();
+
+	/// <summary>
+	/// Broad phase: keep the colliders that overlap the world space bounds of the cloth's substep
+	/// </summary>
+	void GatherNearColliders(const ColliderSet& colliders, glm::vec3 worldMin, glm::vec3 worldMax);
+
+	/// <summary>
+	/// Continuous collision for particles that moved further than the margin this substep: the segment from the previous position
+	/// to the current one is swept against the near colliders (sphere tracing, vertex-triangle against meshes), and a particle
+	/// is stopped where it first came within the margin. Returns the number of particles stopped
+	/// </summary>
+	int SweepColliders(const glm::mat4& modelMatrix);
+
+	/// <summary>
+	/// Analytic primitives and distance fields near the cloth, a block of COLLIDER_BLOCK_SIZE particles at a time
+	/// </summary>
+	void CollidePrimitives(const glm::mat4& modelMatrix);
+
+	/// <summary>
+	/// Triangle meshes, a BVH query per particle. Particles are searched up to maxStep beyond the margin,
+	/// the furthest any particle moved this substep
+	/// </summary>
+	void CollideMeshes(const std::vector<MeshCollider>& meshes, const glm::mat4& modelMatrix, glm::vec3 clothMin, glm::vec3 clothMax, float maxStep);
+
+	/// <summary>
+	/// Wake everything if anything that drives the cloth changed since the last frame
+	/// </summary>
+	void WakeOnChanges(const std::vector<ForceField>& forceFields, const ColliderSet& colliders, const glm::mat4& modelMatrix);
+
+	void SleepTile(size_t tile);
+
+	void WakeTile(size_t tile);
+
+	/// <summary>
+	/// Rebuild the awake particle ranges and the constraint table without asleep-asleep links
+	/// </summary>
+	void UpdateActiveSets();
+
+	ThreadPool& m_pool;
+	IntegrationKernel m_integrate;
+	uint32_t m_windSeed;
+	ClothSolverStats m_stats;
+	float m_residual;				// Largest stretch measured by the last constraint sweep
+	ClothSelfCollision m_selfCollision;
+	ClothImplicit m_implicit;
+
+	// Colliders near the cloth this substep; distance fields and meshes with their transforms
+	struct NearSDF {
+		const SDFGrid* grid;
+		glm::mat4 worldToGrid, gridToWorld;
+		float scale;
+		glm::vec3 min, max;
+	};
+	struct NearMesh {
+		const TriangleBVH* bvh;
+		glm::mat4 worldToMesh;
+		glm::mat3 normalToWorld;
+		glm::vec3 min, max;
+	};
+	const ColliderKernels& m_colliderKernels;
+	ColliderSet m_nearColliders;
+	std::vector<NearSDF> m_nearSDFs;
+	std::vector<NearMesh> m_nearMeshes;
+
+	// Sleeping: asleep particles get an inverse mass of 0, so kernels and constraints leave them alone
+	std::vector<float> m_invMass;					// Inverse masses with every tile awake
+	unsigned int m_tilesX;
+	std::vector<int> m_tileRestFrames;
+	std::vector<uint8_t> m_tileAsleep;
+	std::vector<uint8_t> m_tileMoving;				// Moved past the threshold this frame
+	std::vector<glm::vec3> m_tileMin, m_tileMax;	// Bounds at the last check, asleep tiles keep theirs
+	size_t m_sleepingTiles;
+
+	std::vector<ParticleRange> m_awakeRanges;		// Split to at most MIN_PARTICLES_PER_TASK particles each
+	size_t m_awakeParticles;
+	std::vector<DistanceConstraint> m_activeConstraints;
+	std::vector<size_t> m_activeBatches;
+	std::vector<float> m_lambdas;					// XPBD: Lagrange multiplier of every active constraint this substep
+	float m_substepScale;							// Substep length velocities are stored for
+
+	// Jacobi: the links of every particle, and the positions of the sweep before and the one being written
+	JacobiKernel m_jacobi;
+	AlignedFloats m_restLeft, m_restRight, m_restUp, m_restDown;
+	AlignedFloats m_lastX, m_lastY, m_lastZ;
+	AlignedFloats m_nextX, m_nextY, m_nextZ;
+
+	// Multigrid: where a grid line of the next finer level lies between two lines of a coarse level
+	struct LineWeight {
+		unsigned int line;			// Grid line of the finer level
+		unsigned int lower, upper;	// Neighbouring lines of the coarse level, both line if it is kept
+		float t;					// Weight of upper
+	};
+	struct GridLevel {
+		std::vector<unsigned int> lines;					// Grid rows and columns kept, the same for both axes
+		std::vector<LineWeight> weights;					// One per line of the next finer level
+		std::vector<DistanceConstraint> constraints;		// Links between neighbouring kept particles, coloured like the fine grid
+		std::vector<size_t> batches;
+		std::vector<DistanceConstraint> activeConstraints;
+		std::vector<size_t> activeBatches;
+	};
+	std::vector<GridLevel> m_levels;				// Coarse levels, m_levels[0] has every other line of the fine grid
+	std::vector<glm::vec3> m_cycleStart;			// Positions at the start of the V-cycle
+
+	// What drove the cloth last frame, a change wakes it up
+	std::vector<ForceField> m_lastForceFields;
+	glm::mat4 m_lastModelMatrix;
+	glm::vec3 m_lastGravity;
+	float m_lastSlack;
+	ClothSolverMode m_lastSolverMode;
+	float m_lastCompliance;
+	ColliderSet m_lastColliders;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/// <summary>
+/// How the distance constraints are solved each substep
+/// </summary>
+enum class ClothSolverMode
+{
+	GAUSS_SEIDEL,		// Position based: every sweep pulls links fully back, so stiffness depends on the sweeps and substeps run
+	XPBD,				// Compliant links with Lagrange multipliers: stiffness comes from compliance alone
+	MULTIGRID,			// Gauss-Seidel with corrections from coarser grids first, for fast convergence on fine cloth
+	JACOBI,				// Every particle averages its links' corrections from the last sweep, with Chebyshev acceleration
+	IMPLICIT			// Backward Euler over stretch and shear springs instead of Verlet and constraints: stable at any step length
+};
+
+/// <summary>
+/// Runtime parameters of the cloth solver. Passed at construction and can be changed between frames
+/// </summary>
+struct ClothSolverSettings {
+	ClothSolverMode solverMode = ClothSolverMode::GAUSS_SEIDEL;
+	int substeps = 3;								// Verlet steps per simulated frame
+	int constraintIterations = 10;					// Most sweeps over the constraint table per substep, V-cycles for multigrid,
+													// conjugate gradient iterations for implicit
+	float tolerance = 0.001f;						// Stop sweeping once no link is stretched by more than this fraction.
+													// Implicit: once the residual fell by this factor
+	glm::vec3 gravity = glm::vec3(0.0f, -0.003f, 0.0f);
+	float slack = 1.15f;							// Links may stretch to restLength * slack before they pull back
+	float compliance = 0.0f;						// XPBD: inverse stiffness of the links, 0 is inextensible
+	float stretchStiffness = 1.0f;					// Implicit: spring force along grid edges per unit of relative stretch
+	float shearStiffness = 0.1f;					// Implicit: same for the springs across quad diagonals
+	float chebyshevRho = 0.95f;						// Jacobi: estimated convergence rate of a plain sweep, 0 turns the acceleration off
+	bool tethers = false;							// Keep particles within restLength * slack of the nearest pinned one, before every sweep.
+													// Also caps the stretch compliance would allow
+	bool sleeping = true;							// Let tiles of resting particles fall asleep
+	float sleepThreshold = 0.0001f;					// A tile rests while no particle moves further than this per substep
+	int sleepFrames = 30;							// Frames a tile has to rest before it falls asleep
+	bool selfCollision = false;
+	float thickness = 0.1f;							// Particles that aren't grid neighbours are kept at least this far apart
+	float colliderMargin = 0.05f;					// Distance particles keep from collider surfaces
+	bool continuousCollision = true;				// Sweep fast particles against the colliders so they can't pass through
+	bool clothCollision = false;					// Keep thickness away from the other cloths of a ClothWorld
+};
+
+/// <summary>
+/// What the constraint solver did during the last simulated frame
+/// </summary>
+struct ClothSolverStats {
+	int iterations = 0;								// Constraint sweeps run, summed over all substeps
+	int maxIterations = 0;							// Sweeps the iteration cap would have allowed
+	float residual = 0.0f;							// Largest relative stretch measured by the final sweep of the last substep
+	int sleepingTiles = 0;
+	int selfContacts = 0;							// Self-collision contacts, summed over all substeps
+	int tiles = 0;
+	int clothContacts = 0;							// Contacts with other cloths, summed over all substeps
+	int bvhRefits = 0;								// Cloth BVH updates that only refit the tree
+	int bvhRebuilds = 0;							// Cloth BVH updates that rebuilt it
+	int sweptContacts = 0;							// Particles stopped by continuous collision, summed over all substeps
+};
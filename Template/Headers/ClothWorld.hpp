@@ -0,0 +1,83 @@
+#pragma once
+
+#include <ClothSolver.hpp>
+#include <ClothBVH.hpp>
+#include <ThreadPool.hpp>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// <summary>
+/// Owns any number of cloths and steps them concurrently.
+/// Each cloth is a task on the work-stealing pool, and its own parallel loops nest on the same pool.
+/// Cloths with settings.clothCollision are stepped substep by substep and collide with the others in between
+/// </summary>
+class ClothWorld
+{
+public:
+	explicit ClothWorld(ThreadPool& pool = ThreadPool::Default());
+
+	/// <summary>
+	/// Create a cloth owned by the world. The reference stays valid for the lifetime of the world
+	/// </summary>
+	ClothSolver& AddCloth(float width, float depth, unsigned int wP, unsigned int dP, unsigned int gridRes, float initHeight = 2.0f,
+		const ClothSolverSettings& settings = ClothSolverSettings());
+
+	size_t GetClothCount() const;
+
+	ClothSolver& GetCloth(size_t i);
+
+	/// <summary>
+	/// Advance every cloth by one frame against the same colliders; modelMatrices[i] places cloth i in the scene
+	/// </summary>
+	void Simulate(const std::vector<ForceField>& forceFields, const ColliderSet& colliders,
+		const std::vector<glm::mat4>& modelMatrices, float dt);
+
+	/// <summary>
+	/// Run as many fixed steps of 1 / rate seconds as frameTime covers, carrying the remainder over to the next call,
+	/// so the result doesn't depend on the frame rate. At most maxSteps are run; time beyond that is dropped,
+	/// slowing the simulation down rather than letting a slow frame snowball. Returns the steps run
+	/// </summary>
+	int Advance(const std::vector<ForceField>& forceFields, const ColliderSet& colliders,
+		const std::vector<glm::mat4>& modelMatrices, float frameTime, float rate, int maxSteps);
+
+	/// <summary>
+	/// Time carried over by the last Advance() call as a fraction of a step, in [0, 1)
+	/// </summary>
+	float GetInterpolation() const;
+
+	/// <summary>
+	/// Positions of cloth i, in cloth space, blended between the states before and after the last step by alpha.
+	/// Rendering with alpha = GetInterpolation() stays one step behind but moves smoothly between steps
+	/// </summary>
+	void GetInterpolatedPositions(size_t i, float alpha, std::vector<glm::vec3>& positions) const;
+
+	/// <summary>
+	/// Statistics of the last Simulate() call summed over all cloths; the residual is the largest one.
+	/// After an Advance() that ran no step, only the tile counts are filled in
+	/// </summary>
+	ClothSolverStats GetStats() const;
+
+private:
+	/// <summary>
+	/// Refit every cloth's BVH, then push particles out of the other cloths in two phases:
+	/// gather the pushes of all cloths while positions are only read, then apply them
+	/// </summary>
+	void CollideCloths(const std::vector<glm::mat4>& modelMatrices);
+
+	ThreadPool& m_pool;
+	std::vector<std::unique_ptr<ClothSolver>> m_cloths;
+	std::vector<size_t> m_order;		// Cloth indices, most particles first so big cloths don't start last
+
+	// Fixed stepping
+	double m_accumulator;								// Seconds not yet simulated, less than a step after Advance()
+	float m_interpolation;
+	bool m_stepped;										// False while the last Advance() ran no step
+	std::vector<std::vector<glm::vec3>> m_previous;		// Positions of every cloth before the last step
+
+	// Cloth-vs-cloth collision, one entry per cloth
+	std::vector<ClothBVH> m_bvhs;
+	std::vector<std::vector<glm::vec3>> m_deltas;		// Summed push of every particle, in cloth space
+	std::vector<std::vector<uint32_t>> m_contacts;
+	ClothSolverStats m_collisionStats;					// Only the cloth collision counters are used
+};
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <cstdlib>
+#include <math.h>
+#include <stdexcept>
+#include <utility>
 #include <glm/glm.hpp>
 
 // **********************************************************************
@@ -2,6 +2,7 @@
 
 #include <Camera.hpp>
 #include <Timer.hpp>
+#include <ClothSolverSettings.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -35,8 +36,14 @@ struct SceneSettings {
     float manual_bias = 0.05f;
     int shadow_samples = 40;
     float sim_speed = 1.0f;
+    int sim_rate = 60;                                  // Fixed simulation steps per second
+    int sim_max_steps = 4;                              // Steps a single frame may run; longer frames slow the simulation down
+    int sim_steps = 0;                                  // Steps run in the last frame
     float sim_drag_amount = 0.01f;
     float sim_wind_amount = 0.01f;
+    float sim_sphere_position[3] = { 2.0f, 1.0f, 0.0f };
+    float sim_sphere_radius = 1.0f;
+    float sim_floor_height = 0.0f;
     bool wireframe_mode;
     bool directional_shadows_on = false;
     bool omnidirectional_shadows_on = true;
@@ -44,6 +51,12 @@ struct SceneSettings {
     bool run_sim = false;
     bool sim_drag = false;
     bool sim_wind = false;
+    bool sim_sphere = false;
+    bool sim_floor = false;
+    bool sim_model_sdf = true;
+    bool sim_interpolate = true;
+    ClothSolverSettings cloth_solver;
+    ClothSolverStats cloth_stats;                       // Copied from the solver after each simulated frame
 };
 
 /// <summary>
@@ -74,15 +87,15 @@ struct ModelSettings {
 class GUI
 {
 public:
-    std::vector<ModelSettings> modelSets;
-    ModelSettings customModelSettings, clothSettings;
+    std::vector<ModelSettings> modelSets, clothSets;
+    ModelSettings customModelSettings;
 
     GUI(GLFWwindow* pWindow, Camera& camera, SceneSettings& sceneSettings, Timer& timer);
 
     /// <summary>
     /// Initialize our GUI wrapper
     /// </summary>
-    void Init(size_t nModels);
+    void Init(size_t nModels, size_t nCloths);
 
     /// <summary>
     /// Render our GUI with updated reference data
@@ -105,5 +118,6 @@ private:
     SceneSettings& m_sceneSettings;
     Timer& m_timer;
     std::string m_cameraMode;
-    int nModels;
+    size_t nModels;
+    size_t nCloths;
 };
\ No newline at end of file
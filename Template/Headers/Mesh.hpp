@@ -5,6 +5,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <Shader.hpp>
+#include <TriangleBVH.hpp>
 
 #include <string>
 #include <vector>
@@ -39,6 +40,7 @@ struct Mesh {
     std::vector<Vertex>       vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture>      textures;
+    TriangleBVH               bvh;
     unsigned int VAO;
 
     // constructor
@@ -50,6 +52,12 @@ struct Mesh {
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
+
+        // static collision geometry for the cloth
+        std::vector<glm::vec3> positions(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+            positions[i] = vertices[i].Position;
+        bvh.Build(positions, indices);
     }
 
     // render the mesh
@@ -10,6 +10,7 @@
 
 #include <Mesh.hpp>
 #include <Shader.hpp>
+#include <SDFBaker.hpp>
 
 #include <string>
 #include <fstream>
@@ -25,6 +26,7 @@ struct Model {
     // model data 
     vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
     vector<Mesh> meshes;
+    SDFGrid sdf;                        // distance field of all meshes, for cloth collision
     string directory;
     bool gammaCorrection;
 
@@ -37,6 +39,7 @@ struct Model {
     Model(string const& path, bool gamma = false) : gammaCorrection(gamma)
     {
         loadModel(path);
+        loadSDF(path);
     }
 
     // draws the model, and thus all its meshes
@@ -77,6 +80,19 @@ struct Model {
         processNode(scene->mRootNode, scene);
     }
 
+    // bakes the distance field of the model, or reads it from the .sdf file next to the model if that was baked from the same file.
+    void loadSDF(string const& path)
+    {
+        vector<const TriangleBVH*> bvhs;
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            bvhs.push_back(&meshes[i].bvh);
+
+        if (LoadOrBakeSDF(bvhs, path, path + ".sdf", sdf))
+            cout << "Loaded distance field " << path << ".sdf" << endl;
+        else if (!sdf.IsEmpty())
+            cout << "Baked distance field with " << sdf.GetBrickCount() << " bricks for " << path << endl;
+    }
+
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
     void processNode(aiNode* node, const aiScene* scene)
     {
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <SDFGrid.hpp>
+#include <TriangleBVH.hpp>
+#include <ThreadPool.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Cells across the longest side of a baked model
+#define SDF_BAKE_RESOLUTION 128
+
+// Cells around the surface that get fine samples; farther away the brick corners are used
+#define SDF_BAKE_BAND 4
+
+// Part of the cache key; bump when the baked values change, so bakes made by older code are not loaded
+#define SDF_BAKE_VERSION 2
+
+// FNV-1a 64 bit
+#define FNV_OFFSET_BASIS 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+/// <summary>
+/// Mix size bytes into an FNV-1a hash
+/// </summary>
+uint64_t HashBytes(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS);
+
+/// <summary>
+/// FNV-1a hash of a file's contents. False if it can't be read
+/// </summary>
+bool HashFile(const std::string& path, uint64_t& hash);
+
+/// <summary>
+/// Bake the signed distance field of static triangle meshes, all in the same space, with samples cellSize apart.
+/// Bricks that may come within band of a surface get fine samples. Each brick is filled as one task on the pool.
+/// The sign comes from the normal of the closest face, or the angle weighted normal of the closest edge or corner,
+/// so it is exact for closed meshes. Open meshes work too, but behind their faces counts as inside
+/// </summary>
+void BakeSDF(const std::vector<const TriangleBVH*>& meshes, float cellSize, float band, SDFGrid& grid, ThreadPool& pool = ThreadPool::Default());
+
+/// <summary>
+/// Bake meshes at SDF_BAKE_RESOLUTION cells across their longest side, or load an earlier bake from cachePath
+/// if it was made from the same sourcePath contents with the same settings. A new bake is written to cachePath.
+/// Returns true if the grid came from the cache
+/// </summary>
+bool LoadOrBakeSDF(const std::vector<const TriangleBVH*>& meshes, const std::string& sourcePath, const std::string& cachePath, SDFGrid& grid,
+	ThreadPool& pool = ThreadPool::Default());
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Cells along each edge of a brick; a brick stores (SDF_BRICK_SIZE + 1)^3 samples so lookups never cross bricks
+#define SDF_BRICK_SIZE 8
+#define SDF_BRICK_SAMPLES ((SDF_BRICK_SIZE + 1) * (SDF_BRICK_SIZE + 1) * (SDF_BRICK_SIZE + 1))
+
+// No brick allocated in a slot of the brick table
+#define SDF_NO_BRICK 0xffffffffu
+
+/// <summary>
+/// Sparse signed distance field, negative inside the surface. The region is split into bricks of SDF_BRICK_SIZE^3 cells:
+/// a coarse grid holds the distance at every brick corner, and only bricks near the surface store fine samples.
+/// Fine sample i, j, k of a brick sits at its corner + (i, j, k) * cellSize; values in between are interpolated trilinearly
+/// </summary>
+class SDFGrid
+{
+public:
+	SDFGrid();
+
+	/// <summary>
+	/// Clear to bricks bricks per axis starting at origin, with every coarse sample 0 and no fine bricks
+	/// </summary>
+	void Reset(glm::vec3 origin, float cellSize, glm::ivec3 bricks);
+
+	bool IsEmpty() const;
+
+	inline float& Coarse(int i, int j, int k)
+	{
+		return m_coarse[(static_cast<size_t>(k) * (m_bricks.y + 1) + j) * (m_bricks.x + 1) + i];
+	}
+
+	inline float Coarse(int i, int j, int k) const
+	{
+		return m_coarse[(static_cast<size_t>(k) * (m_bricks.y + 1) + j) * (m_bricks.x + 1) + i];
+	}
+
+	/// <summary>
+	/// Allocate the fine samples of brick (i, j, k), returning its index for GetBrick(). Not thread safe
+	/// </summary>
+	uint32_t AddBrick(int i, int j, int k);
+
+	/// <summary>
+	/// SDF_BRICK_SAMPLES fine samples, x fastest, then y, then z
+	/// </summary>
+	inline float* GetBrick(uint32_t brick)
+	{
+		return m_samples.data() + static_cast<size_t>(brick) * SDF_BRICK_SAMPLES;
+	}
+
+	/// <summary>
+	/// Index of brick (i, j, k), SDF_NO_BRICK if it only has coarse samples
+	/// </summary>
+	inline uint32_t FindBrick(int i, int j, int k) const
+	{
+		return m_brickTable[(static_cast<size_t>(k) * m_bricks.y + j) * m_bricks.x + i];
+	}
+
+	size_t GetBrickCount() const;
+
+	glm::vec3 GetOrigin() const;
+
+	float GetCellSize() const;
+
+	/// <summary>
+	/// Bricks per axis
+	/// </summary>
+	glm::ivec3 GetBricks() const;
+
+	/// <summary>
+	/// Region covered by the samples
+	/// </summary>
+	void GetBounds(glm::vec3& min, glm::vec3& max) const;
+
+	/// <summary>
+	/// Interpolated distance at point and its gradient (not normalized). False if point is outside the grid
+	/// </summary>
+	bool Sample(glm::vec3 point, float& distance, glm::vec3& gradient) const;
+
+	/// <summary>
+	/// Write the grid to a binary file tagged with key, e.g. a hash of what it was baked from
+	/// </summary>
+	bool Save(const std::string& path, uint64_t key) const;
+
+	/// <summary>
+	/// Read a grid written by Save(). False, leaving the grid untouched, if the file is missing, damaged or has another key
+	/// </summary>
+	bool Load(const std::string& path, uint64_t key);
+
+private:
+	glm::vec3 m_origin;
+	float m_cellSize;
+	glm::ivec3 m_bricks;
+	std::vector<float> m_coarse;				// (bricks + 1)^3 brick corners, x fastest, then y, then z
+	std::vector<uint32_t> m_brickTable;			// Brick index of every brick slot, or SDF_NO_BRICK
+	std::vector<float> m_samples;				// SDF_BRICK_SAMPLES per allocated brick
+};
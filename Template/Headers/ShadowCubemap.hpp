@@ -8,6 +8,7 @@
 #include <GUI.hpp>
 #include <CustomModel.hpp>
 #include <ClothMesh.hpp>
+#include <memory>
 #include <vector>
 
 class ShadowCubemap {
@@ -24,7 +25,7 @@ public:
 	~ShadowCubemap();
 
 	void Render(float* lightPos, std::vector<Model>& models, const int nModels, GUI& gui, CustomModel* customModel = nullptr,
-		ClothMesh* clothMesh = nullptr);
+		std::vector<std::unique_ptr<ClothMesh>>* cloths = nullptr);
 
     void GetLightSpaceMatrices(float* lightPos, std::vector<glm::mat4>& lightTransformMatrices);
 };
@@ -8,6 +8,7 @@
 #include <GUI.hpp>
 #include <CustomModel.hpp>
 #include <ClothMesh.hpp>
+#include <memory>
 #include <vector>
 
 static const float debugQuadVertices[] = {
@@ -53,7 +54,7 @@ public:
 	~ShadowMap();
 
 	void Render(float* lightPos, glm::mat4& lightProjection, std::vector<Model>& models, const int nModels, GUI& gui,
-        CustomModel* customModel = nullptr, ClothMesh* clothMesh = nullptr);
+        CustomModel* customModel = nullptr, std::vector<std::unique_ptr<ClothMesh>>* cloths = nullptr);
 
 	void Debug();
 
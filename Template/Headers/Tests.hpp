@@ -5,30 +5,374 @@
 #include <string>
 #include <iostream>
 #include <glm/glm.hpp>
-#include <Sphere.hpp>
+#include <ExtraMath.hpp>
+#include <ClothKernels.hpp>
+#include <ClothColliders.hpp>
+#include <ClothSolver.hpp>
 
-void SphereIntersectionTest(glm::vec3& pos, Sphere& sphere)
+bool IntegrationKernelTest(IntegrationKernel kernel, const IntegrationTerms& terms, const std::string& label)
 {
-	const std::string log = std::to_string(pos.x) + " | " + std::to_string(pos.y) + " | " + std::to_string(pos.z);
-	std::cout << log << std::endl;
+	// Odd particle count so the scalar tail of the SIMD kernels is exercised too
+	const size_t count = 1003;
+	const float tolerance = 1e-5f;
 
-	std::pair<bool, glm::vec3> collisionData = sphere.CheckVertexCollision(pos, glm::mat4(1.0f));
+	ClothParticles expected;
+	expected.Resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		expected.SetPosition(i, Random3f(-5.0f, 5.0f));
+		expected.SetPrevPosition(i, expected.GetPosition(i) + Random3f(-0.1f, 0.1f));
+		expected.invMass[i] = (i % 17 == 0) ? 0.0f : 1.0f;
+	}
+	ClothParticles actual = expected;
 
-	if (collisionData.first)
+	IntegrateScalar(expected, 0, count, terms);
+	kernel(actual, 0, count, terms);
+
+	float maxError = 0.0f;
+	for (size_t i = 0; i < count; i++)
 	{
-		const std::string res = "Collision detected with impulse: "
-			+ std::to_string(collisionData.second.x) + " | " + std::to_string(collisionData.second.y) + " | " + std::to_string(collisionData.second.z);
-		std::cout << res << std::endl;
+		maxError = std::max(maxError, glm::length(expected.GetPosition(i) - actual.GetPosition(i)));
+		maxError = std::max(maxError, glm::length(expected.GetPrevPosition(i) - actual.GetPrevPosition(i)));
 	}
+
+	const bool passed = maxError <= tolerance;
+	std::cout << GetIntegrationKernelName(kernel) << " " << label << ": max error " << maxError
+		<< (passed ? " PASSED" : " FAILED") << std::endl;
+
+	return passed;
+}
+
+/// <summary>
+/// Print that a SIMD kernel wasn't tested because the running CPU can't run it
+/// </summary>
+void KernelSkipped(const std::string& label)
+{
+	std::cout << label << ": not supported by this CPU, SKIPPED" << std::endl;
+}
+
+/// <summary>
+/// Compare an integration kernel with the scalar one under every kind of external term
+/// </summary>
+bool IntegrationKernelTests(IntegrationKernel kernel)
+{
+	IntegrationTerms gravityTerms;
+	gravityTerms.acceleration = glm::vec3(0.0f, -0.003f * 0.016f, 0.0f);
+
+	IntegrationTerms dragTerms;
+	dragTerms.damping = 0.5f * 0.016f;
+
+	IntegrationTerms windTerms;
+	windTerms.wind = 0.3f * 0.016f;
+	windTerms.windSeed = 7;
+
+	IntegrationTerms fusedTerms = gravityTerms;
+	fusedTerms.damping = dragTerms.damping;
+	fusedTerms.wind = windTerms.wind;
+	fusedTerms.windSeed = 11;
+
+	bool passed = IntegrationKernelTest(kernel, gravityTerms, "gravity");
+	passed = IntegrationKernelTest(kernel, dragTerms, "drag") && passed;
+	passed = IntegrationKernelTest(kernel, windTerms, "wind") && passed;
+	passed = IntegrationKernelTest(kernel, fusedTerms, "gravity + drag + wind") && passed;
+
+	return passed;
+}
+
+/// <summary>
+/// Test every SIMD integration kernel compiled in that the CPU can run, not just the one it selects
+/// </summary>
+bool IntegrationKernelTesting()
+{
+	bool passed = true;
+
+#ifdef CLOTH_KERNELS_X86
+	if (CpuSupports(false))
+		passed = IntegrationKernelTests(IntegrateSSE) && passed;
 	else
-		std::cout << "No collision detected" << std::endl;
+		KernelSkipped("SSE4.1 integration");
+
+	if (CpuSupports(true))
+		passed = IntegrationKernelTests(IntegrateAVX2) && passed;
+	else
+		KernelSkipped("AVX2 integration");
+#endif
+
+	return passed;
 }
 
-void SphereIntersectionTesting()
+/// <summary>
+/// Run a collider kernel and the scalar reference on the same random block, compare the results
+/// </summary>
+template <typename Collider>
+bool ColliderKernelTest(void (*kernel)(ColliderBlock&, const Collider&, float), void (*reference)(ColliderBlock&, const Collider&, float),
+	const Collider& collider, const char* name, const std::string& label)
 {
-	std::array<glm::vec3, 3> vertexInputs = { glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f) };
-	Sphere sphereInput(glm::vec3(0.0f), 2.0f);
-	
-	for (size_t i = 0; i < 3; i++)
-		SphereIntersectionTest(vertexInputs[i], sphereInput);
-}
\ No newline at end of file
+	const float margin = 0.1f;
+	const float tolerance = 1e-4f;
+
+	ColliderBlock expected;
+	expected.count = COLLIDER_BLOCK_SIZE;
+	for (size_t i = 0; i < expected.count; i++)
+	{
+		const glm::vec3 point = Random3f(-3.0f, 3.0f);
+		expected.x[i] = point.x;
+		expected.y[i] = point.y;
+		expected.z[i] = point.z;
+	}
+	ColliderBlock actual = expected;
+
+	reference(expected, collider, margin);
+	kernel(actual, collider, margin);
+
+	float maxError = 0.0f;
+	for (size_t i = 0; i < expected.count; i++)
+		maxError = std::max(maxError, glm::length(glm::vec3(expected.x[i] - actual.x[i], expected.y[i] - actual.y[i], expected.z[i] - actual.z[i])));
+
+	const bool passed = maxError <= tolerance;
+	std::cout << name << " " << label << ": max error " << maxError << (passed ? " PASSED" : " FAILED") << std::endl;
+
+	return passed;
+}
+
+/// <summary>
+/// Compare a set of collider kernels with the scalar ones
+/// </summary>
+bool ColliderKernelTests(const ColliderKernels& kernels)
+{
+	const ColliderKernels& scalar = GetScalarColliderKernels();
+
+	const SphereCollider sphere = { glm::vec3(0.5f, 0.0f, -0.5f), 1.5f };
+	const CapsuleCollider capsule = { glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(1.0f, 1.5f, 0.5f), 0.8f };
+	const BoxCollider box = { glm::vec3(0.2f, -0.3f, 0.1f),
+		glm::mat3(glm::vec3(0.8f, 0.6f, 0.0f), glm::vec3(-0.6f, 0.8f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(1.5f, 0.7f, 1.0f) };
+	const PlaneCollider plane = { glm::vec3(0.0f, 1.0f, 0.0f), -0.5f };
+
+	bool passed = ColliderKernelTest(kernels.sphere, scalar.sphere, sphere, kernels.name, "sphere");
+	passed = ColliderKernelTest(kernels.capsule, scalar.capsule, capsule, kernels.name, "capsule") && passed;
+	passed = ColliderKernelTest(kernels.box, scalar.box, box, kernels.name, "box") && passed;
+	passed = ColliderKernelTest(kernels.plane, scalar.plane, plane, kernels.name, "plane") && passed;
+
+	// A point inside the sphere ends up on its surface plus the margin
+	ColliderBlock block;
+	block.count = 8;
+	for (size_t i = 0; i < block.count; i++)
+	{
+		block.x[i] = 0.5f + 1.0f;
+		block.y[i] = 0.0f;
+		block.z[i] = -0.5f;
+	}
+	kernels.sphere(block, sphere, 0.1f);
+
+	const bool pushed = fabsf(block.x[0] - (0.5f + 1.6f)) <= 1e-5f;
+	std::cout << kernels.name << " sphere push: " << block.x[0] << (pushed ? " PASSED" : " FAILED") << std::endl;
+
+	return passed && pushed;
+}
+
+/// <summary>
+/// Test every SIMD collider kernel set compiled in that the CPU can run
+/// </summary>
+bool ColliderKernelTesting()
+{
+	bool passed = true;
+
+#ifdef CLOTH_KERNELS_X86
+	if (CpuSupports(true))
+		passed = ColliderKernelTests(GetAVX2ColliderKernels()) && passed;
+	else
+		KernelSkipped("AVX2 colliders");
+#endif
+
+	return passed;
+}
+
+/// <summary>
+/// Run a Jacobi sweep with kernel and the scalar reference over the same jittered grid, compare the results
+/// </summary>
+bool JacobiKernelTest(JacobiKernel kernel)
+{
+	// Odd resolution so the SIMD kernel's row ends and tail are exercised too
+	const unsigned int gridRes = 37;
+	const size_t count = gridRes * gridRes;
+	const float tolerance = 1e-5f;
+
+	ClothParticles particles;
+	particles.Resize(count);
+	AlignedFloats restLeft(count, 0.0f), restRight(count, 0.0f), restUp(count, 0.0f), restDown(count, 0.0f);
+	AlignedFloats lastX(count), lastY(count), lastZ(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		const unsigned int x = static_cast<unsigned int>(i % gridRes), y = static_cast<unsigned int>(i / gridRes);
+		particles.SetPosition(i, glm::vec3(x * 0.1f, 0.0f, y * 0.1f) + Random3f(-0.05f, 0.05f));
+		particles.invMass[i] = (i % 13 == 0) ? 0.0f : 1.0f;
+
+		const glm::vec3 last = particles.GetPosition(i) + Random3f(-0.01f, 0.01f);
+		lastX[i] = last.x;
+		lastY[i] = last.y;
+		lastZ[i] = last.z;
+
+		// Every link of a particle and its neighbour agree, some are missing
+		if (x + 1 < gridRes && i % 7 != 0)
+			restRight[i] = restLeft[i + 1] = 0.1f;
+		if (y + 1 < gridRes && i % 11 != 0)
+			restDown[i] = restUp[i + gridRes] = 0.1f;
+	}
+
+	AlignedFloats expectedX(count), expectedY(count), expectedZ(count);
+	AlignedFloats actualX(count), actualY(count), actualZ(count);
+
+	JacobiTerms terms;
+	terms.x = particles.x.data();
+	terms.y = particles.y.data();
+	terms.z = particles.z.data();
+	terms.lastX = lastX.data();
+	terms.lastY = lastY.data();
+	terms.lastZ = lastZ.data();
+	terms.invMass = particles.invMass.data();
+	terms.restLeft = restLeft.data();
+	terms.restRight = restRight.data();
+	terms.restUp = restUp.data();
+	terms.restDown = restDown.data();
+	terms.gridRes = gridRes;
+	terms.slack = 1.05f;
+	terms.omega = 1.3f;
+
+	float expectedStretch = 0.0f, actualStretch = 0.0f;
+	for (size_t row = 0; row < gridRes; row++)
+	{
+		terms.outX = expectedX.data();
+		terms.outY = expectedY.data();
+		terms.outZ = expectedZ.data();
+		expectedStretch = std::max(expectedStretch, JacobiScalar(terms, row));
+
+		terms.outX = actualX.data();
+		terms.outY = actualY.data();
+		terms.outZ = actualZ.data();
+		actualStretch = std::max(actualStretch, kernel(terms, row));
+	}
+
+	float maxError = fabsf(expectedStretch - actualStretch);
+	for (size_t i = 0; i < count; i++)
+		maxError = std::max(maxError, glm::length(glm::vec3(expectedX[i] - actualX[i], expectedY[i] - actualY[i], expectedZ[i] - actualZ[i])));
+
+	const bool passed = maxError <= tolerance;
+	std::cout << GetJacobiKernelName(kernel) << " Jacobi sweep: max error " << maxError << (passed ? " PASSED" : " FAILED") << std::endl;
+
+	return passed;
+}
+
+/// <summary>
+/// Test every SIMD Jacobi kernel compiled in that the CPU can run
+/// </summary>
+bool JacobiKernelTesting()
+{
+	bool passed = true;
+
+#ifdef CLOTH_KERNELS_X86
+	if (CpuSupports(true))
+		passed = JacobiKernelTest(JacobiAVX2) && passed;
+	else
+		KernelSkipped("AVX2 Jacobi sweep");
+#endif
+
+	return passed;
+}
+
+/// <summary>
+/// Run a set of conjugate gradient kernels and the scalar ones on the same random vectors, compare the results
+/// </summary>
+bool ConjugateGradientKernelTest(const ConjugateGradientKernels& kernels)
+{
+	// Odd count so the scalar tail of the SIMD kernels is exercised too
+	const size_t count = 1003;
+	const float tolerance = 1e-4f;
+
+	const ConjugateGradientKernels& scalar = GetScalarConjugateGradientKernels();
+
+	AlignedFloats x(count), r(count), p(count), q(count), invDiagonal(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		x[i] = Random(-1.0f, 1.0f);
+		r[i] = Random(-1.0f, 1.0f);
+		p[i] = Random(-1.0f, 1.0f);
+		q[i] = Random(-1.0f, 1.0f);
+		invDiagonal[i] = Random(0.1f, 2.0f);
+	}
+
+	// Sums are accumulated in a different order, so they are compared relative to their size
+	const float expectedDot = scalar.dot(p.data(), q.data(), count);
+	float maxError = fabsf(kernels.dot(p.data(), q.data(), count) - expectedDot) / std::max(fabsf(expectedDot), 1.0f);
+
+	AlignedFloats expectedX = x, expectedR = r, expectedZ(count), expectedP = p;
+	AlignedFloats actualX = x, actualR = r, actualZ(count), actualP = p;
+
+	const float expectedRz = scalar.step(expectedX.data(), expectedR.data(), expectedZ.data(), p.data(), q.data(), invDiagonal.data(), 0.7f, count);
+	const float actualRz = kernels.step(actualX.data(), actualR.data(), actualZ.data(), p.data(), q.data(), invDiagonal.data(), 0.7f, count);
+	maxError = std::max(maxError, fabsf(actualRz - expectedRz) / std::max(fabsf(expectedRz), 1.0f));
+
+	scalar.direction(expectedP.data(), expectedZ.data(), 0.3f, count);
+	kernels.direction(actualP.data(), actualZ.data(), 0.3f, count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		maxError = std::max(maxError, fabsf(expectedX[i] - actualX[i]));
+		maxError = std::max(maxError, fabsf(expectedR[i] - actualR[i]));
+		maxError = std::max(maxError, fabsf(expectedZ[i] - actualZ[i]));
+		maxError = std::max(maxError, fabsf(expectedP[i] - actualP[i]));
+	}
+
+	const bool passed = maxError <= tolerance;
+	std::cout << kernels.name << " conjugate gradient: max error " << maxError << (passed ? " PASSED" : " FAILED") << std::endl;
+
+	return passed;
+}
+
+/// <summary>
+/// Test every SIMD conjugate gradient kernel set compiled in that the CPU can run
+/// </summary>
+bool ConjugateGradientKernelTesting()
+{
+	bool passed = true;
+
+#ifdef CLOTH_KERNELS_X86
+	if (CpuSupports(true))
+		passed = ConjugateGradientKernelTest(GetAVX2ConjugateGradientKernels()) && passed;
+	else
+		KernelSkipped("AVX2 conjugate gradient");
+#endif
+
+	return passed;
+}
+
+/// <summary>
+/// Stretch the two links of a 2x2 cloth to four times their rest length and run a single Gauss-Seidel sweep.
+/// Each link has one pinned end, so the sweep should leave it at exactly restLength * slack
+/// </summary>
+bool LinkProjectionTest()
+{
+	const float tolerance = 1e-5f;
+
+	ClothSolverSettings settings;
+	settings.solverMode = ClothSolverMode::GAUSS_SEIDEL;
+	settings.constraintIterations = 1;
+	settings.tethers = false;
+	settings.sleeping = false;
+
+	// Top row pinned, the free row below it pulled away along the links
+	ClothSolver cloth(1.0f, 1.0f, 1, 1, 2, 2.0f, settings);
+	for (size_t i = 2; i < 4; i++)
+		cloth.particles.SetPosition(i, cloth.particles.GetPosition(i) + glm::vec3(0.0f, 0.0f, 3.0f));
+
+	cloth.ApplyConstraints(1.0f);
+
+	// Rest length is 1, the link is 4 long
+	float maxError = 0.0f;
+	for (size_t i = 2; i < 4; i++)
+		maxError = std::max(maxError, fabsf(glm::length(cloth.particles.GetPosition(i) - cloth.particles.GetPosition(i - 2)) - settings.slack));
+
+	const bool passed = maxError <= tolerance;
+	std::cout << "Link projection: max error " << maxError << (passed ? " PASSED" : " FAILED") << std::endl;
+
+	return passed;
+}
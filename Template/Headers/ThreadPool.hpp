@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Chunks a loop is split into per thread at most, so threads that finish early can steal from the slow ones
+#define CHUNKS_PER_THREAD 4
+
+/// <summary>
+/// Work-stealing scheduler used by the cloth solvers for data-parallel loops.
+/// Every thread owns a queue of loops; idle threads steal chunks from the other queues, and a thread
+/// waiting for its loop to finish runs queued chunks meanwhile, so loops can be nested freely
+/// </summary>
+class ThreadPool
+{
+public:
+	/// <summary>
+	/// Create a pool that runs loops on threadCount threads in total (the calling thread included).
+	/// 0 picks std::thread::hardware_concurrency()
+	/// </summary>
+	explicit ThreadPool(unsigned int threadCount = 0);
+
+	~ThreadPool();
+
+	/// <summary>
+	/// Number of threads a loop is spread over, the calling thread included
+	/// </summary>
+	unsigned int GetThreadCount() const;
+
+	/// <summary>
+	/// Split [0, count) into contiguous chunks of about equal size and run fn(begin, end) on each, returning when all
+	/// chunks are done. There are up to CHUNKS_PER_THREAD chunks per thread, each at least minChunk items long unless
+	/// count itself is shorter. Chunk boundaries only depend on count, minChunk and the thread count.
+	/// fn may call ParallelFor or ParallelTasks itself. An exception thrown by fn is rethrown once all chunks are done
+	/// </summary>
+	void ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& fn);
+
+	/// <summary>
+	/// Run fn(i) for every i in [0, count) as a separate task, for a few coarse items of uneven cost.
+	/// Tasks are started in index order
+	/// </summary>
+	void ParallelTasks(size_t count, const std::function<void(size_t)>& fn);
+
+	/// <summary>
+	/// Pool shared by solvers that weren't handed one explicitly
+	/// </summary>
+	static ThreadPool& Default();
+
+private:
+	/// <summary>
+	/// One ParallelFor call, lives on the caller's stack until all its chunks are finished
+	/// </summary>
+	struct Job {
+		const std::function<void(size_t, size_t)>* fn;
+		size_t count;
+		size_t chunkCount;
+		size_t nextChunk;						// Guarded by the mutex of the queue holding the job
+		std::atomic<size_t> finishedChunks;
+
+		// Only the caller waits for the job: the thread finishing its last chunk sets done under the mutex
+		std::mutex mutex;
+		std::condition_variable finished;
+		bool done;
+		std::exception_ptr error;				// First exception thrown by a chunk, rethrown to the caller. Guarded by mutex
+	};
+
+	/// <summary>
+	/// Jobs with unclaimed chunks, pushed by one thread. The owner takes the newest, thieves the oldest
+	/// </summary>
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<Job*> jobs;
+	};
+
+	void WorkerLoop(size_t queue);
+
+	/// <summary>
+	/// Push job onto the calling thread's queue, help with it and wait until its last chunk is done
+	/// </summary>
+	void RunJob(Job& job);
+
+	/// <summary>
+	/// Claim and run one chunk from a queue; false if it was empty
+	/// </summary>
+	bool RunChunk(WorkQueue& queue, bool newest);
+
+	/// <summary>
+	/// Run one chunk from any queue, own queue first
+	/// </summary>
+	bool RunAnyChunk(size_t ownQueue);
+
+	/// <summary>
+	/// Queue of the calling thread. Threads outside the pool share queue 0
+	/// </summary>
+	size_t GetLocalQueue() const;
+
+	std::vector<std::thread> m_workers;
+	std::vector<std::unique_ptr<WorkQueue>> m_queues;	// Queue 0 for outside threads, queue i for worker i
+
+	// Idle workers sleep on m_wake. m_generation changes whenever a job is pushed, which wakes as many sleepers
+	// as the job has chunks for
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::atomic<uint64_t> m_generation;		// Changed under m_mutex, read without it
+	unsigned int m_sleeping;
+	bool m_quit;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Triangles per leaf
+#define BVH_LEAF_SIZE 4
+
+// Triangles whose area is below this fraction of their longest edge squared are left out as degenerate
+#define BVH_SLIVER_RATIO 1e-5f
+
+// Deep enough for any tree built from median splits, and for SAH trees capped at BVH_MAX_DEPTH
+#define BVH_STACK_SIZE 64
+#define BVH_MAX_DEPTH 48
+
+/// <summary>
+/// Part of a triangle abc a closest point lies on. The corners and edges come first, in the order
+/// TriangleBVH stores their normals
+/// </summary>
+enum class TriangleFeature
+{
+	CORNER_A,
+	CORNER_B,
+	CORNER_C,
+	EDGE_AB,
+	EDGE_BC,
+	EDGE_CA,
+	FACE
+};
+
+/// <summary>
+/// Node of a TriangleBVH. Leaves hold triangles [first, first + count), inner nodes (count 0) have their
+/// children at first and first + 1
+/// </summary>
+struct BVHNode {
+	glm::vec3 min;
+	uint32_t first;
+	glm::vec3 max;
+	uint32_t count;
+};
+
+/// <summary>
+/// Bounding volume hierarchy over a static triangle mesh, built once and then only queried
+/// </summary>
+class TriangleBVH
+{
+public:
+	TriangleBVH();
+
+	/// <summary>
+	/// Build over the triangles of an indexed mesh (3 indices per triangle), splitting nodes at the
+	/// median centroid along their longest axis. Degenerate triangles are left out
+	/// </summary>
+	void Build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices);
+
+	bool IsEmpty() const;
+
+	size_t GetTriangleCount() const;
+
+	/// <summary>
+	/// Bounds of the whole mesh
+	/// </summary>
+	void GetBounds(glm::vec3& min, glm::vec3& max) const;
+
+	/// <summary>
+	/// Closest point of the mesh to point, if it is nearer than maxDistance. normal is the face normal if the closest
+	/// point is inside a triangle, else the angle weighted normal of the edge or corner it is on, so point lies behind
+	/// it exactly when it is inside a closed mesh
+	/// </summary>
+	bool ClosestPoint(glm::vec3 point, float maxDistance, glm::vec3& closest, glm::vec3& normal) const;
+
+	/// <summary>
+	/// First triangle hit by the segment origin + direction * [0, maxT], from either side, or only on their front
+	/// if frontFacesOnly, so a front face behind a nearer back face is still found.
+	/// t is where along it, normal the face normal of the triangle
+	/// </summary>
+	bool Raycast(glm::vec3 origin, glm::vec3 direction, float maxT, float& t, glm::vec3& normal, bool frontFacesOnly = false) const;
+
+private:
+	void BuildNode(uint32_t node, uint32_t first, uint32_t count, const std::vector<glm::vec3>& centroids, std::vector<uint32_t>& order);
+
+	std::vector<BVHNode> m_nodes;					// Root first
+	std::vector<glm::vec3> m_corners;				// 3 corners per triangle, in leaf order
+	std::vector<glm::vec3> m_normals;				// Unit face normal per triangle
+	std::vector<glm::vec3> m_featureNormals;		// 6 per triangle: unit pseudonormals of its corners and edges, in TriangleFeature order
+};
+
+/// <summary>
+/// Closest point to p on triangle abc
+/// </summary>
+glm::vec3 ClosestPointOnTriangle(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c);
+
+/// <summary>
+/// Closest point to p on triangle abc, and the part of the triangle it lies on
+/// </summary>
+glm::vec3 ClosestPointOnTriangle(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c, TriangleFeature& feature);
+
+/// <summary>
+/// Where the ray origin + direction * t enters the box [min, max], given 1 / direction. Infinity if it misses
+/// </summary>
+float RayBoxEntry(glm::vec3 origin, glm::vec3 inverseDirection, glm::vec3 min, glm::vec3 max);
+
+/// <summary>
+/// Squared distance from p to the box [min, max], 0 inside
+/// </summary>
+inline float DistanceSquaredToBox(glm::vec3 p, glm::vec3 min, glm::vec3 max)
+{
+	const glm::vec3 outside = glm::max(glm::max(min - p, p - max), glm::vec3(0.0f));
+	return glm::dot(outside, outside);
+}
@@ -0,0 +1,45 @@
+#version 400 core
+
+in vec3 fragPos;
+in vec3 fragNormal;
+in vec2 fragTexCoords;
+
+out vec4 FragColor;
+
+uniform sampler2D texture_diffuse;
+
+uniform vec3 lightPos;
+uniform vec3 pointLightPos;
+uniform vec3 viewPos;
+uniform vec3 lightColor;
+
+vec3 CalculateLight(vec3 color, vec3 normal, vec3 position)
+{
+	// ambient
+	vec3 ambient = 0.3 * lightColor;
+	// diffuse
+	vec3 lightDir = normalize(position - fragPos);
+	float diff = max(dot(lightDir, normal), 0.0);
+	vec3 diffuse = diff * lightColor;
+	// specular, kept weak for fabric
+	vec3 viewDir = normalize(viewPos - fragPos);
+	vec3 halfwayDir = normalize(lightDir + viewDir);
+	float spec = pow(max(dot(normal, halfwayDir), 0.0), 16.0);
+	vec3 specular = 0.2 * spec * lightColor;
+
+	return (ambient + diffuse + specular) * color;
+}
+
+void main()
+{
+	vec3 color = texture(texture_diffuse, fragTexCoords).rgb;
+
+	// Cloth is seen from both sides
+	vec3 normal = normalize(fragNormal);
+	if (!gl_FrontFacing)
+		normal = -normal;
+
+	vec3 lighting = CalculateLight(color, normal, lightPos) + CalculateLight(color, normal, pointLightPos);
+
+	FragColor = vec4(lighting, 1.0f);
+}
@@ -0,0 +1,20 @@
+#version 400 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoords;
+layout (location = 2) in vec3 aNormal;
+
+out vec3 fragPos;
+out vec3 fragNormal;
+out vec2 fragTexCoords;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+
+void main()
+{
+	fragPos = vec3(model * vec4(aPos, 1.0f));
+	fragNormal = transpose(inverse(mat3(model))) * aNormal;
+	fragTexCoords = aTexCoords;
+	gl_Position = projection * view * vec4(fragPos, 1.0f);
+}
@@ -0,0 +1,216 @@
+#include <ClothRenderer.hpp>
+
+#include <stb_image.h>
+#include <algorithm>
+#include <direct.h>
+#include <iostream>
+
+// Longest single wait for the GPU to release a copy of the ring, in nanoseconds
+#define CLOTH_FENCE_TIMEOUT 1000000
+
+ClothRenderer::ClothRenderer(const ClothSolver& solver, std::string textureFile)
+	:
+	m_indexCount(solver.triIndices.size()),
+	m_vertexCount(solver.particles.count),
+	m_mapped(nullptr),
+	m_slot(0)
+{
+	for (int i = 0; i < CLOTH_STREAM_FRAMES; i++)
+		m_fences[i] = nullptr;
+
+	// Load texture
+	char buffer[1024];
+	getcwd(buffer, 1024);
+	std::string texturePath(buffer);
+	//texturePath += "\\..\\textures\\clothTexture.jpg";
+	texturePath += "\\..\\textures\\" + textureFile;
+
+	textureId = TextureFromFile(texturePath.c_str(), false);
+
+	// Set up buffers
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &streamVBO);
+	glGenBuffers(1, &texCoordVBO);
+	glGenBuffers(1, &EBO);
+
+	glBindVertexArray(VAO);
+
+	const bool bufferStorage = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+	const GLsizeiptr vertexBytes = 2 * m_vertexCount * sizeof(glm::vec3);
+
+	// Vertex positions and normals, streamed every frame
+	glBindBuffer(GL_ARRAY_BUFFER, streamVBO);
+	if (bufferStorage)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, vertexBytes * CLOTH_STREAM_FRAMES, nullptr, flags);
+		m_mapped = static_cast<glm::vec3*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexBytes * CLOTH_STREAM_FRAMES, flags));
+	}
+
+	if (m_mapped == nullptr)
+	{
+		m_staging.resize(2 * m_vertexCount);
+		glBufferData(GL_ARRAY_BUFFER, vertexBytes, nullptr, GL_STREAM_DRAW);
+	}
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)(m_vertexCount * sizeof(glm::vec3)));
+	glEnableVertexAttribArray(2);
+
+	// The first copy of the ring, which the attributes already point at
+	GatherPositions(solver);
+	glm::vec3* vertices = m_mapped != nullptr ? m_mapped : m_staging.data();
+	std::copy(m_positions.begin(), m_positions.end(), vertices);
+	std::copy(m_normals.begin(), m_normals.end(), vertices + m_vertexCount);
+	if (m_mapped == nullptr)
+		glBufferSubData(GL_ARRAY_BUFFER, 0, vertexBytes, m_staging.data());
+
+	// Vertex texCoords, uploaded once
+	const GLsizeiptr texCoordBytes = solver.texCoords.size() * sizeof(glm::vec2);
+	glBindBuffer(GL_ARRAY_BUFFER, texCoordVBO);
+	if (bufferStorage)
+		glBufferStorage(GL_ARRAY_BUFFER, texCoordBytes, solver.texCoords.data(), 0);
+	else
+		glBufferData(GL_ARRAY_BUFFER, texCoordBytes, solver.texCoords.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+	glEnableVertexAttribArray(1);
+
+	const GLsizeiptr indexBytes = solver.triIndices.size() * sizeof(unsigned int);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	if (bufferStorage)
+		glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, indexBytes, solver.triIndices.data(), 0);
+	else
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, solver.triIndices.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindVertexArray(0);
+}
+
+ClothRenderer::~ClothRenderer()
+{
+	for (int i = 0; i < CLOTH_STREAM_FRAMES; i++)
+		if (m_fences[i] != nullptr)
+			glDeleteSync(m_fences[i]);
+}
+
+void ClothRenderer::UpdateVertices(const ClothSolver& solver)
+{
+	GatherPositions(solver);
+	UpdateVertices(m_positions, m_normals);
+}
+
+void ClothRenderer::UpdateVertices(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals)
+{
+	glm::vec3* vertices = BeginUpload();
+	std::copy(positions.begin(), positions.begin() + std::min(positions.size(), m_vertexCount), vertices);
+	std::copy(normals.begin(), normals.begin() + std::min(normals.size(), m_vertexCount), vertices + m_vertexCount);
+	EndUpload();
+}
+
+void ClothRenderer::Render(Shader& shader, glm::mat4 model)
+{
+	shader.use();
+	shader.setMat4("model", model);
+
+	glBindTexture(GL_TEXTURE_2D, textureId);
+
+	glDisable(GL_CULL_FACE);
+
+	glBindVertexArray(VAO);
+
+	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indexCount), GL_UNSIGNED_INT, 0);
+
+	glBindVertexArray(0);
+
+	glEnable(GL_CULL_FACE);
+}
+
+void ClothRenderer::GatherPositions(const ClothSolver& solver)
+{
+	m_positions.resize(m_vertexCount);
+	for (size_t i = 0; i < m_vertexCount; i++)
+		m_positions[i] = solver.particles.GetPosition(i);
+
+	solver.ComputeNormals(m_positions, m_normals);
+}
+
+glm::vec3* ClothRenderer::BeginUpload()
+{
+	if (m_mapped == nullptr)
+		return m_staging.data();
+
+	// Everything drawn from the current copy so far has to finish before it is written again
+	m_fences[m_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_slot = (m_slot + 1) % CLOTH_STREAM_FRAMES;
+
+	if (m_fences[m_slot] != nullptr)
+	{
+		GLenum result = glClientWaitSync(m_fences[m_slot], GL_SYNC_FLUSH_COMMANDS_BIT, CLOTH_FENCE_TIMEOUT);
+		while (result == GL_TIMEOUT_EXPIRED)
+			result = glClientWaitSync(m_fences[m_slot], 0, CLOTH_FENCE_TIMEOUT);
+
+		glDeleteSync(m_fences[m_slot]);
+		m_fences[m_slot] = nullptr;
+	}
+
+	return m_mapped + 2 * m_slot * m_vertexCount;
+}
+
+void ClothRenderer::EndUpload()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, streamVBO);
+
+	if (m_mapped == nullptr)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0, m_staging.size() * sizeof(glm::vec3), m_staging.data());
+		return;
+	}
+
+	// The buffer is coherent, so the writes are visible to commands issued from here on
+	const size_t offset = 2 * m_slot * m_vertexCount * sizeof(glm::vec3);
+	glBindVertexArray(VAO);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)offset);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)(offset + m_vertexCount * sizeof(glm::vec3)));
+	glBindVertexArray(0);
+}
+
+unsigned int ClothRenderer::TextureFromFile(const char* path, bool gamma)
+{
+	std::string filename = std::string(path);
+
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+
+	int width, height, nrComponents;
+	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+	if (data)
+	{
+		GLenum format;
+		if (nrComponents == 1)
+			format = GL_RED;
+		else if (nrComponents == 3)
+			format = GL_RGB;
+		else if (nrComponents == 4)
+			format = GL_RGBA;
+
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		stbi_image_free(data);
+	}
+	else
+	{
+		std::cout << "Texture failed to load at path: " << path << std::endl;
+		stbi_image_free(data);
+	}
+
+	return textureID;
+}
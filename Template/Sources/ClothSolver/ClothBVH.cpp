@@ -0,0 +1,311 @@
+#include <ClothBVH.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+static inline float SurfaceArea(glm::vec3 min, glm::vec3 max)
+{
+	const glm::vec3 extent = max - min;
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+ClothBVH::ClothBVH()
+	:
+	m_cost(0.0f),
+	m_builtCost(0.0f)
+{}
+
+bool ClothBVH::Update(const ClothParticles& particles, const std::vector<unsigned int>& triIndices, const glm::mat4& modelMatrix)
+{
+	m_positions.resize(particles.count);
+	for (size_t i = 0; i < particles.count; i++)
+		m_positions[i] = glm::vec3(modelMatrix * glm::vec4(particles.GetPosition(i), 1.0f));
+
+	// New topology
+	if (m_nodes.empty() || m_triangles.size() != triIndices.size())
+	{
+		m_triangles.assign(triIndices.begin(), triIndices.end());
+		Build();
+		return true;
+	}
+
+	m_cost = Refit();
+	if (m_cost <= m_builtCost * BVH_REBUILD_RATIO)
+		return false;
+
+	// m_triangles is in the old leaf order, which is as good a start as any
+	Build();
+	return true;
+}
+
+bool ClothBVH::IsEmpty() const
+{
+	return m_nodes.empty();
+}
+
+void ClothBVH::GetBounds(glm::vec3& min, glm::vec3& max) const
+{
+	if (m_nodes.empty())
+	{
+		min = max = glm::vec3(0.0f);
+		return;
+	}
+
+	min = m_nodes[0].min;
+	max = m_nodes[0].max;
+}
+
+float ClothBVH::GetCost() const
+{
+	return m_cost;
+}
+
+void ClothBVH::Build()
+{
+	m_nodes.clear();
+
+	const size_t triangleCount = m_triangles.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	std::vector<glm::vec3> centroids(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++)
+		centroids[t] = (m_positions[m_triangles[t * 3]] + m_positions[m_triangles[t * 3 + 1]] + m_positions[m_triangles[t * 3 + 2]]) / 3.0f;
+
+	std::vector<uint32_t> order(triangleCount);
+	std::iota(order.begin(), order.end(), 0);
+
+	m_nodes.reserve(2 * triangleCount);
+	m_nodes.push_back(BVHNode());
+
+	BuildNode(0, 0, static_cast<uint32_t>(triangleCount), 0, centroids, order);
+
+	// Store the triangles in leaf order, so a leaf reads one contiguous block
+	std::vector<uint32_t> sortedTriangles(m_triangles.size());
+	for (size_t t = 0; t < triangleCount; t++)
+		for (int corner = 0; corner < 3; corner++)
+			sortedTriangles[t * 3 + corner] = m_triangles[order[t] * 3 + corner];
+
+	m_triangles.swap(sortedTriangles);
+
+	m_cost = m_builtCost = Refit();
+}
+
+void ClothBVH::BuildNode(uint32_t node, uint32_t first, uint32_t count, int depth, const std::vector<glm::vec3>& centroids,
+	std::vector<uint32_t>& order)
+{
+	glm::vec3 centroidMin = centroids[order[first]], centroidMax = centroidMin;
+	for (uint32_t t = first; t < first + count; t++)
+	{
+		centroidMin = glm::min(centroidMin, centroids[order[t]]);
+		centroidMax = glm::max(centroidMax, centroids[order[t]]);
+	}
+
+	// Bounds are filled in by Refit()
+	m_nodes[node].first = first;
+	m_nodes[node].count = count;
+
+	if (count <= BVH_LEAF_SIZE || depth >= BVH_MAX_DEPTH)
+		return;
+
+	// Binned SAH: sort the centroids into bins along each axis and try every boundary between bins,
+	// costing a split as the summed surface area times triangle count of both sides
+	float bestCost = std::numeric_limits<float>::max();
+	int bestAxis = -1, bestSplit = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+			continue;
+
+		const float binScale = BVH_SAH_BINS / extent;
+
+		uint32_t binCount[BVH_SAH_BINS] = {};
+		glm::vec3 binMin[BVH_SAH_BINS], binMax[BVH_SAH_BINS];
+		for (int bin = 0; bin < BVH_SAH_BINS; bin++)
+		{
+			binMin[bin] = glm::vec3(std::numeric_limits<float>::max());
+			binMax[bin] = glm::vec3(-std::numeric_limits<float>::max());
+		}
+
+		for (uint32_t t = first; t < first + count; t++)
+		{
+			const uint32_t triangle = order[t];
+			const int bin = std::min(BVH_SAH_BINS - 1, static_cast<int>((centroids[triangle][axis] - centroidMin[axis]) * binScale));
+
+			binCount[bin]++;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				binMin[bin] = glm::min(binMin[bin], m_positions[m_triangles[triangle * 3 + corner]]);
+				binMax[bin] = glm::max(binMax[bin], m_positions[m_triangles[triangle * 3 + corner]]);
+			}
+		}
+
+		// Right side of every boundary, swept from the far end
+		float rightCost[BVH_SAH_BINS];
+		glm::vec3 sweepMin(std::numeric_limits<float>::max()), sweepMax(-std::numeric_limits<float>::max());
+		uint32_t sweepCount = 0;
+		for (int bin = BVH_SAH_BINS - 1; bin > 0; bin--)
+		{
+			sweepCount += binCount[bin];
+			sweepMin = glm::min(sweepMin, binMin[bin]);
+			sweepMax = glm::max(sweepMax, binMax[bin]);
+			rightCost[bin] = sweepCount > 0 ? SurfaceArea(sweepMin, sweepMax) * sweepCount : 0.0f;
+		}
+
+		sweepMin = glm::vec3(std::numeric_limits<float>::max());
+		sweepMax = glm::vec3(-std::numeric_limits<float>::max());
+		sweepCount = 0;
+		for (int split = 1; split < BVH_SAH_BINS; split++)
+		{
+			sweepCount += binCount[split - 1];
+			sweepMin = glm::min(sweepMin, binMin[split - 1]);
+			sweepMax = glm::max(sweepMax, binMax[split - 1]);
+
+			// Both sides need triangles
+			if (sweepCount == 0 || sweepCount == count)
+				continue;
+
+			const float cost = SurfaceArea(sweepMin, sweepMax) * sweepCount + rightCost[split];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	// Every centroid in the same spot
+	if (bestAxis < 0)
+		return;
+
+	const float binScale = BVH_SAH_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	const auto middle = std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t triangle)
+	{
+		return std::min(BVH_SAH_BINS - 1, static_cast<int>((centroids[triangle][bestAxis] - centroidMin[bestAxis]) * binScale)) < bestSplit;
+	});
+	const uint32_t leftCount = static_cast<uint32_t>(middle - (order.begin() + first));
+
+	const uint32_t children = static_cast<uint32_t>(m_nodes.size());
+	m_nodes.push_back(BVHNode());
+	m_nodes.push_back(BVHNode());
+
+	m_nodes[node].first = children;
+	m_nodes[node].count = 0;
+
+	BuildNode(children, first, leftCount, depth + 1, centroids, order);
+	BuildNode(children + 1, first + leftCount, count - leftCount, depth + 1, centroids, order);
+}
+
+float ClothBVH::Refit()
+{
+	float cost = 0.0f;
+
+	// Children are stored after their parent, so walking backwards visits them first
+	for (size_t n = m_nodes.size(); n-- > 0;)
+	{
+		BVHNode& node = m_nodes[n];
+
+		if (node.count > 0)
+		{
+			glm::vec3 min = m_positions[m_triangles[node.first * 3]], max = min;
+			for (uint32_t t = node.first; t < node.first + node.count; t++)
+			{
+				for (int corner = 0; corner < 3; corner++)
+				{
+					min = glm::min(min, m_positions[m_triangles[t * 3 + corner]]);
+					max = glm::max(max, m_positions[m_triangles[t * 3 + corner]]);
+				}
+			}
+
+			node.min = min;
+			node.max = max;
+			cost += SurfaceArea(min, max) * node.count;
+		}
+		else
+		{
+			node.min = glm::min(m_nodes[node.first].min, m_nodes[node.first + 1].min);
+			node.max = glm::max(m_nodes[node.first].max, m_nodes[node.first + 1].max);
+			cost += SurfaceArea(node.min, node.max);
+		}
+	}
+
+	const float rootArea = m_nodes.empty() ? 0.0f : SurfaceArea(m_nodes[0].min, m_nodes[0].max);
+	return rootArea > 0.0f ? cost / rootArea : 0.0f;
+}
+
+bool ClothBVH::ClosestPoint(glm::vec3 point, float maxDistance, glm::vec3& closest, glm::vec3& normal) const
+{
+	if (m_nodes.empty())
+		return false;
+
+	float best = maxDistance * maxDistance;
+	uint32_t bestTriangle = 0;
+	bool found = false;
+
+	// Nodes still to visit, with the distance of their box measured when they were pushed
+	uint32_t stack[BVH_STACK_SIZE];
+	float stackDistance[BVH_STACK_SIZE];
+	int top = 0;
+	stack[top] = 0;
+	stackDistance[top++] = DistanceSquaredToBox(point, m_nodes[0].min, m_nodes[0].max);
+
+	while (top > 0)
+	{
+		top--;
+		if (stackDistance[top] >= best)
+			continue;
+
+		const BVHNode& node = m_nodes[stack[top]];
+		if (node.count > 0)
+		{
+			for (uint32_t t = node.first; t < node.first + node.count; t++)
+			{
+				const glm::vec3 candidate = ClosestPointOnTriangle(point, m_positions[m_triangles[t * 3]],
+					m_positions[m_triangles[t * 3 + 1]], m_positions[m_triangles[t * 3 + 2]]);
+				const glm::vec3 offset = point - candidate;
+				const float distanceSquared = glm::dot(offset, offset);
+
+				if (distanceSquared < best)
+				{
+					best = distanceSquared;
+					closest = candidate;
+					bestTriangle = t;
+					found = true;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first, it is the more likely to shrink the search radius
+		const uint32_t left = node.first, right = node.first + 1;
+		const float leftDistance = DistanceSquaredToBox(point, m_nodes[left].min, m_nodes[left].max);
+		const float rightDistance = DistanceSquaredToBox(point, m_nodes[right].min, m_nodes[right].max);
+		const bool leftFirst = leftDistance <= rightDistance;
+
+		if (std::max(leftDistance, rightDistance) < best)
+		{
+			stack[top] = leftFirst ? right : left;
+			stackDistance[top++] = std::max(leftDistance, rightDistance);
+		}
+		if (std::min(leftDistance, rightDistance) < best)
+		{
+			stack[top] = leftFirst ? left : right;
+			stackDistance[top++] = std::min(leftDistance, rightDistance);
+		}
+	}
+
+	if (found)
+	{
+		// Cloth triangles deform, so their normals aren't stored
+		const glm::vec3 a = m_positions[m_triangles[bestTriangle * 3]];
+		const glm::vec3 faceNormal = glm::cross(m_positions[m_triangles[bestTriangle * 3 + 1]] - a, m_positions[m_triangles[bestTriangle * 3 + 2]] - a);
+		const float length = glm::length(faceNormal);
+		normal = length > 0.0f ? faceNormal / length : glm::vec3(0.0f);
+	}
+
+	return found;
+}
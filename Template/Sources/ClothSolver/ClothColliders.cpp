@@ -0,0 +1,311 @@
+#include <ClothColliders.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+// **********************************************************************
+// Bounds
+// **********************************************************************
+
+bool GetColliderBounds(const SphereCollider& collider, glm::vec3& min, glm::vec3& max)
+{
+	min = collider.center - collider.radius;
+	max = collider.center + collider.radius;
+	return true;
+}
+
+bool GetColliderBounds(const CapsuleCollider& collider, glm::vec3& min, glm::vec3& max)
+{
+	min = glm::min(collider.a, collider.b) - collider.radius;
+	max = glm::max(collider.a, collider.b) + collider.radius;
+	return true;
+}
+
+bool GetColliderBounds(const BoxCollider& collider, glm::vec3& min, glm::vec3& max)
+{
+	// Half extent along each world axis: the box axes' components weighted by the box half extents
+	const glm::vec3 extent = glm::abs(collider.rotation[0]) * collider.halfExtents.x + glm::abs(collider.rotation[1]) * collider.halfExtents.y
+		+ glm::abs(collider.rotation[2]) * collider.halfExtents.z;
+
+	min = collider.center - extent;
+	max = collider.center + extent;
+	return true;
+}
+
+bool GetColliderBounds(const PlaneCollider& /*collider*/, glm::vec3& min, glm::vec3& max)
+{
+	min = glm::vec3(-std::numeric_limits<float>::max());
+	max = glm::vec3(std::numeric_limits<float>::max());
+	return false;
+}
+
+void TransformBounds(const glm::mat4& transform, glm::vec3& min, glm::vec3& max)
+{
+	glm::vec3 transformedMin(std::numeric_limits<float>::max()), transformedMax(-std::numeric_limits<float>::max());
+
+	for (int corner = 0; corner < 8; corner++)
+	{
+		const glm::vec3 point((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+		const glm::vec3 transformed = glm::vec3(transform * glm::vec4(point, 1.0f));
+		transformedMin = glm::min(transformedMin, transformed);
+		transformedMax = glm::max(transformedMax, transformed);
+	}
+
+	min = transformedMin;
+	max = transformedMax;
+}
+
+bool GetColliderBounds(const SDFCollider& collider, glm::vec3& min, glm::vec3& max)
+{
+	if (collider.grid == nullptr || collider.grid->IsEmpty())
+	{
+		min = max = glm::vec3(0.0f);
+		return true;
+	}
+
+	collider.grid->GetBounds(min, max);
+	TransformBounds(collider.modelMatrix, min, max);
+	return true;
+}
+
+bool GetColliderBounds(const MeshCollider& collider, glm::vec3& min, glm::vec3& max)
+{
+	if (collider.bvh == nullptr || collider.bvh->IsEmpty())
+	{
+		min = max = glm::vec3(0.0f);
+		return true;
+	}
+
+	collider.bvh->GetBounds(min, max);
+	TransformBounds(collider.modelMatrix, min, max);
+	return true;
+}
+
+// **********************************************************************
+// Distances
+// **********************************************************************
+
+/// <summary>
+/// Normal along offset, or up for a point exactly on the feature
+/// </summary>
+static inline glm::vec3 SafeNormal(glm::vec3 offset, float length)
+{
+	return length > 0.0f ? offset / length : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+float GetColliderDistance(const SphereCollider& collider, glm::vec3 point, glm::vec3& normal)
+{
+	const glm::vec3 offset = point - collider.center;
+	const float length = glm::length(offset);
+
+	normal = SafeNormal(offset, length);
+	return length - collider.radius;
+}
+
+float GetColliderDistance(const CapsuleCollider& collider, glm::vec3 point, glm::vec3& normal)
+{
+	const glm::vec3 axis = collider.b - collider.a;
+	const float lengthSquared = glm::dot(axis, axis);
+	const float t = lengthSquared > 0.0f ? glm::clamp(glm::dot(point - collider.a, axis) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+
+	const glm::vec3 offset = point - (collider.a + axis * t);
+	const float length = glm::length(offset);
+
+	normal = SafeNormal(offset, length);
+	return length - collider.radius;
+}
+
+float GetColliderDistance(const BoxCollider& collider, glm::vec3 point, glm::vec3& normal)
+{
+	const glm::vec3 local = glm::transpose(collider.rotation) * (point - collider.center);
+	const glm::vec3 outside = local - glm::clamp(local, -collider.halfExtents, collider.halfExtents);
+
+	if (outside != glm::vec3(0.0f))
+	{
+		const float distance = glm::length(outside);
+		normal = collider.rotation * (outside / distance);
+		return distance;
+	}
+
+	// Inside: the nearest face, as in the kernels
+	const glm::vec3 depth = glm::abs(local) - collider.halfExtents;
+	const int axis = depth.x >= depth.y && depth.x >= depth.z ? 0 : (depth.y >= depth.z ? 1 : 2);
+	normal = collider.rotation[axis] * (local[axis] < 0.0f ? -1.0f : 1.0f);
+	return depth[axis];
+}
+
+float GetColliderDistance(const PlaneCollider& collider, glm::vec3 point, glm::vec3& normal)
+{
+	normal = collider.normal;
+	return glm::dot(collider.normal, point) - collider.offset;
+}
+
+float GetSDFDistance(const SDFGrid& grid, const glm::mat4& worldToGrid, const glm::mat4& gridToWorld, float scale, glm::vec3 point, glm::vec3& normal)
+{
+	const glm::vec3 gridPoint = glm::vec3(worldToGrid * glm::vec4(point, 1.0f));
+
+	float distance;
+	glm::vec3 gradient;
+	if (grid.Sample(gridPoint, distance, gradient))
+	{
+		const glm::vec3 worldGradient = glm::mat3(gridToWorld) * gradient;
+		normal = SafeNormal(worldGradient, glm::length(worldGradient));
+		return distance * scale;
+	}
+
+	glm::vec3 min, max;
+	grid.GetBounds(min, max);
+	const glm::vec3 outside = gridPoint - glm::clamp(gridPoint, min, max);
+	const glm::vec3 worldOutside = glm::mat3(gridToWorld) * outside;
+	const float length = glm::length(worldOutside);
+
+	normal = SafeNormal(worldOutside, length);
+	return length;
+}
+
+// **********************************************************************
+// Scalar kernels, the reference for the SIMD ones
+// **********************************************************************
+
+/// <summary>
+/// Move the point along (dx, dy, dz), whose length is its distance to the nearest feature, until it is minDistance away
+/// </summary>
+static inline void PushOut(float& x, float& y, float& z, float dx, float dy, float dz, float minDistance)
+{
+	const float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+	const float push = minDistance - distance;
+
+	// A point exactly on the feature has no direction to leave in
+	if (push > 0.0f && distance > 0.0f)
+	{
+		const float scale = push / distance;
+		x += dx * scale;
+		y += dy * scale;
+		z += dz * scale;
+	}
+}
+
+void CollideSphereScalar(ColliderBlock& block, const SphereCollider& sphere, float margin)
+{
+	const float minDistance = sphere.radius + margin;
+
+	for (size_t i = 0; i < block.count; i++)
+		PushOut(block.x[i], block.y[i], block.z[i], block.x[i] - sphere.center.x, block.y[i] - sphere.center.y, block.z[i] - sphere.center.z, minDistance);
+}
+
+void CollideCapsuleScalar(ColliderBlock& block, const CapsuleCollider& capsule, float margin)
+{
+	const float minDistance = capsule.radius + margin;
+	const glm::vec3 axis = capsule.b - capsule.a;
+	const float lengthSquared = glm::dot(axis, axis);
+	const float inverseLengthSquared = lengthSquared > 0.0f ? 1.0f / lengthSquared : 0.0f;
+
+	for (size_t i = 0; i < block.count; i++)
+	{
+		const float ax = block.x[i] - capsule.a.x, ay = block.y[i] - capsule.a.y, az = block.z[i] - capsule.a.z;
+		const float t = std::min(std::max((ax * axis.x + ay * axis.y + az * axis.z) * inverseLengthSquared, 0.0f), 1.0f);
+
+		PushOut(block.x[i], block.y[i], block.z[i], ax - axis.x * t, ay - axis.y * t, az - axis.z * t, minDistance);
+	}
+}
+
+void CollideBoxScalar(ColliderBlock& block, const BoxCollider& box, float margin)
+{
+	const glm::vec3 u = box.rotation[0], v = box.rotation[1], w = box.rotation[2];
+	const glm::vec3 h = box.halfExtents;
+
+	for (size_t i = 0; i < block.count; i++)
+	{
+		const float px = block.x[i] - box.center.x, py = block.y[i] - box.center.y, pz = block.z[i] - box.center.z;
+
+		// Box space
+		const glm::vec3 local(px * u.x + py * u.y + pz * u.z, px * v.x + py * v.y + pz * v.z, px * w.x + py * w.y + pz * w.z);
+		const glm::vec3 outside = local - glm::clamp(local, -h, h);
+
+		glm::vec3 push(0.0f);
+		if (outside != glm::vec3(0.0f))
+		{
+			// Away from the nearest point of the surface
+			const float distance = glm::length(outside);
+			if (distance < margin)
+				push = outside * ((margin - distance) / distance);
+		}
+		else
+		{
+			// Out through the nearest face
+			const glm::vec3 depth = glm::abs(local) - h;
+			const int axis = depth.x >= depth.y && depth.x >= depth.z ? 0 : (depth.y >= depth.z ? 1 : 2);
+			push[axis] = (local[axis] < 0.0f ? -1.0f : 1.0f) * (margin - depth[axis]);
+		}
+
+		block.x[i] += u.x * push.x + v.x * push.y + w.x * push.z;
+		block.y[i] += u.y * push.x + v.y * push.y + w.y * push.z;
+		block.z[i] += u.z * push.x + v.z * push.y + w.z * push.z;
+	}
+}
+
+void CollidePlaneScalar(ColliderBlock& block, const PlaneCollider& plane, float margin)
+{
+	for (size_t i = 0; i < block.count; i++)
+	{
+		const float height = block.x[i] * plane.normal.x + block.y[i] * plane.normal.y + block.z[i] * plane.normal.z - plane.offset;
+		const float push = std::max(margin - height, 0.0f);
+
+		block.x[i] += plane.normal.x * push;
+		block.y[i] += plane.normal.y * push;
+		block.z[i] += plane.normal.z * push;
+	}
+}
+
+void CollideSDF(ColliderBlock& block, const SDFGrid& grid, const glm::mat4& worldToGrid, const glm::mat4& gridToWorld, float scale, float margin)
+{
+	// The margin in grid units
+	const float gridMargin = margin / scale;
+
+	for (size_t i = 0; i < block.count; i++)
+	{
+		const glm::vec3 point = glm::vec3(worldToGrid * glm::vec4(block.x[i], block.y[i], block.z[i], 1.0f));
+
+		float distance;
+		glm::vec3 gradient;
+		if (!grid.Sample(point, distance, gradient) || distance >= gridMargin)
+			continue;
+
+		const float length = glm::length(gradient);
+		if (length == 0.0f)
+			continue;
+
+		const glm::vec3 resolved = glm::vec3(gridToWorld * glm::vec4(point + gradient * ((gridMargin - distance) / length), 1.0f));
+		block.x[i] = resolved.x;
+		block.y[i] = resolved.y;
+		block.z[i] = resolved.z;
+	}
+}
+
+// **********************************************************************
+// Selection
+// **********************************************************************
+
+const ColliderKernels& GetScalarColliderKernels()
+{
+	static const ColliderKernels kernels = { CollideSphereScalar, CollideCapsuleScalar, CollideBoxScalar, CollidePlaneScalar, "Scalar" };
+	return kernels;
+}
+
+#ifdef CLOTH_KERNELS_X86
+const ColliderKernels& GetAVX2ColliderKernels()
+{
+	static const ColliderKernels kernels = { CollideSphereAVX2, CollideCapsuleAVX2, CollideBoxAVX2, CollidePlaneAVX2, "AVX2" };
+	return kernels;
+}
+#endif
+
+const ColliderKernels& SelectColliderKernels()
+{
+#ifdef CLOTH_KERNELS_X86
+	if (SelectIntegrationKernel() == IntegrateAVX2)
+		return GetAVX2ColliderKernels();
+#endif
+	return GetScalarColliderKernels();
+}
@@ -0,0 +1,178 @@
+// Built with AVX2 + FMA code generation, only called after SelectColliderKernels() checked the CPU
+#include <ClothColliders.hpp>
+
+#ifdef CLOTH_KERNELS_X86
+#include <immintrin.h>
+
+// Same as PushOut() in ClothColliders.cpp for 8 points
+static inline void PushOut8(__m256& x, __m256& y, __m256& z, __m256 dx, __m256 dy, __m256 dz, __m256 minDistance)
+{
+	const __m256 zero = _mm256_setzero_ps();
+
+	const __m256 distance = _mm256_sqrt_ps(_mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz))));
+	const __m256 push = _mm256_sub_ps(minDistance, distance);
+
+	// Lanes that don't move get a scale of 0, which also masks the division by a zero distance
+	const __m256 moves = _mm256_and_ps(_mm256_cmp_ps(push, zero, _CMP_GT_OQ), _mm256_cmp_ps(distance, zero, _CMP_GT_OQ));
+	const __m256 scale = _mm256_and_ps(moves, _mm256_div_ps(push, distance));
+
+	x = _mm256_fmadd_ps(dx, scale, x);
+	y = _mm256_fmadd_ps(dy, scale, y);
+	z = _mm256_fmadd_ps(dz, scale, z);
+}
+
+void CollideSphereAVX2(ColliderBlock& block, const SphereCollider& sphere, float margin)
+{
+	const __m256 centerX = _mm256_set1_ps(sphere.center.x);
+	const __m256 centerY = _mm256_set1_ps(sphere.center.y);
+	const __m256 centerZ = _mm256_set1_ps(sphere.center.z);
+	const __m256 minDistance = _mm256_set1_ps(sphere.radius + margin);
+
+	for (size_t i = 0; i < block.count; i += 8)
+	{
+		__m256 x = _mm256_load_ps(block.x + i);
+		__m256 y = _mm256_load_ps(block.y + i);
+		__m256 z = _mm256_load_ps(block.z + i);
+
+		PushOut8(x, y, z, _mm256_sub_ps(x, centerX), _mm256_sub_ps(y, centerY), _mm256_sub_ps(z, centerZ), minDistance);
+
+		_mm256_store_ps(block.x + i, x);
+		_mm256_store_ps(block.y + i, y);
+		_mm256_store_ps(block.z + i, z);
+	}
+}
+
+void CollideCapsuleAVX2(ColliderBlock& block, const CapsuleCollider& capsule, float margin)
+{
+	const float axisX = capsule.b.x - capsule.a.x, axisY = capsule.b.y - capsule.a.y, axisZ = capsule.b.z - capsule.a.z;
+	const float lengthSquared = axisX * axisX + axisY * axisY + axisZ * axisZ;
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 aX = _mm256_set1_ps(capsule.a.x);
+	const __m256 aY = _mm256_set1_ps(capsule.a.y);
+	const __m256 aZ = _mm256_set1_ps(capsule.a.z);
+	const __m256 abX = _mm256_set1_ps(axisX);
+	const __m256 abY = _mm256_set1_ps(axisY);
+	const __m256 abZ = _mm256_set1_ps(axisZ);
+	const __m256 inverseLengthSquared = _mm256_set1_ps(lengthSquared > 0.0f ? 1.0f / lengthSquared : 0.0f);
+	const __m256 minDistance = _mm256_set1_ps(capsule.radius + margin);
+
+	for (size_t i = 0; i < block.count; i += 8)
+	{
+		__m256 x = _mm256_load_ps(block.x + i);
+		__m256 y = _mm256_load_ps(block.y + i);
+		__m256 z = _mm256_load_ps(block.z + i);
+
+		const __m256 ax = _mm256_sub_ps(x, aX);
+		const __m256 ay = _mm256_sub_ps(y, aY);
+		const __m256 az = _mm256_sub_ps(z, aZ);
+
+		// Nearest point of the segment, clamped to its ends
+		__m256 t = _mm256_mul_ps(_mm256_fmadd_ps(ax, abX, _mm256_fmadd_ps(ay, abY, _mm256_mul_ps(az, abZ))), inverseLengthSquared);
+		t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+
+		PushOut8(x, y, z, _mm256_fnmadd_ps(abX, t, ax), _mm256_fnmadd_ps(abY, t, ay), _mm256_fnmadd_ps(abZ, t, az), minDistance);
+
+		_mm256_store_ps(block.x + i, x);
+		_mm256_store_ps(block.y + i, y);
+		_mm256_store_ps(block.z + i, z);
+	}
+}
+
+void CollideBoxAVX2(ColliderBlock& block, const BoxCollider& box, float margin)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 signBit = _mm256_set1_ps(-0.0f);
+	const __m256 marginV = _mm256_set1_ps(margin);
+	const __m256 centerX = _mm256_set1_ps(box.center.x);
+	const __m256 centerY = _mm256_set1_ps(box.center.y);
+	const __m256 centerZ = _mm256_set1_ps(box.center.z);
+
+	// The rotation's 9 floats column by column, read directly: calling glm's operator[] here would emit a copy of it
+	// built for AVX2 that the linker could share with the rest of the program
+	const float* rotation = reinterpret_cast<const float*>(&box.rotation);
+
+	__m256 axis[3][3];
+	for (int a = 0; a < 3; a++)
+		for (int c = 0; c < 3; c++)
+			axis[a][c] = _mm256_set1_ps(rotation[a * 3 + c]);
+
+	const __m256 half[3] = { _mm256_set1_ps(box.halfExtents.x), _mm256_set1_ps(box.halfExtents.y), _mm256_set1_ps(box.halfExtents.z) };
+
+	for (size_t i = 0; i < block.count; i += 8)
+	{
+		__m256 x = _mm256_load_ps(block.x + i);
+		__m256 y = _mm256_load_ps(block.y + i);
+		__m256 z = _mm256_load_ps(block.z + i);
+
+		const __m256 px = _mm256_sub_ps(x, centerX);
+		const __m256 py = _mm256_sub_ps(y, centerY);
+		const __m256 pz = _mm256_sub_ps(z, centerZ);
+
+		// Box space coordinates, their part outside the box and how deep inside each slab they are
+		__m256 local[3], outside[3], depth[3];
+		for (int a = 0; a < 3; a++)
+		{
+			local[a] = _mm256_fmadd_ps(px, axis[a][0], _mm256_fmadd_ps(py, axis[a][1], _mm256_mul_ps(pz, axis[a][2])));
+			const __m256 clamped = _mm256_min_ps(_mm256_max_ps(local[a], _mm256_sub_ps(zero, half[a])), half[a]);
+			outside[a] = _mm256_sub_ps(local[a], clamped);
+			depth[a] = _mm256_sub_ps(_mm256_andnot_ps(signBit, local[a]), half[a]);
+		}
+
+		// Outside: away from the nearest point of the surface, out to the margin
+		const __m256 distance = _mm256_sqrt_ps(_mm256_fmadd_ps(outside[0], outside[0],
+			_mm256_fmadd_ps(outside[1], outside[1], _mm256_mul_ps(outside[2], outside[2]))));
+		const __m256 isOutside = _mm256_cmp_ps(distance, zero, _CMP_GT_OQ);
+		const __m256 outsideScale = _mm256_and_ps(_mm256_and_ps(isOutside, _mm256_cmp_ps(distance, marginV, _CMP_LT_OQ)),
+			_mm256_div_ps(_mm256_sub_ps(marginV, distance), distance));
+
+		// Inside: out through the face of the shallowest slab, x winning ties over y over z
+		const __m256 pickX = _mm256_and_ps(_mm256_cmp_ps(depth[0], depth[1], _CMP_GE_OQ), _mm256_cmp_ps(depth[0], depth[2], _CMP_GE_OQ));
+		const __m256 pickY = _mm256_andnot_ps(pickX, _mm256_cmp_ps(depth[1], depth[2], _CMP_GE_OQ));
+		const __m256 pickZ = _mm256_andnot_ps(_mm256_or_ps(pickX, pickY), _mm256_castsi256_ps(_mm256_set1_epi32(-1)));
+		const __m256 pick[3] = { pickX, pickY, pickZ };
+
+		__m256 push[3];
+		for (int a = 0; a < 3; a++)
+		{
+			const __m256 insidePush = _mm256_and_ps(pick[a],
+				_mm256_or_ps(_mm256_sub_ps(marginV, depth[a]), _mm256_and_ps(signBit, local[a])));
+			push[a] = _mm256_blendv_ps(insidePush, _mm256_mul_ps(outside[a], outsideScale), isOutside);
+		}
+
+		// Back to world space
+		x = _mm256_fmadd_ps(axis[0][0], push[0], _mm256_fmadd_ps(axis[1][0], push[1], _mm256_fmadd_ps(axis[2][0], push[2], x)));
+		y = _mm256_fmadd_ps(axis[0][1], push[0], _mm256_fmadd_ps(axis[1][1], push[1], _mm256_fmadd_ps(axis[2][1], push[2], y)));
+		z = _mm256_fmadd_ps(axis[0][2], push[0], _mm256_fmadd_ps(axis[1][2], push[1], _mm256_fmadd_ps(axis[2][2], push[2], z)));
+
+		_mm256_store_ps(block.x + i, x);
+		_mm256_store_ps(block.y + i, y);
+		_mm256_store_ps(block.z + i, z);
+	}
+}
+
+void CollidePlaneAVX2(ColliderBlock& block, const PlaneCollider& plane, float margin)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 normalX = _mm256_set1_ps(plane.normal.x);
+	const __m256 normalY = _mm256_set1_ps(plane.normal.y);
+	const __m256 normalZ = _mm256_set1_ps(plane.normal.z);
+	const __m256 surface = _mm256_set1_ps(plane.offset + margin);
+
+	for (size_t i = 0; i < block.count; i += 8)
+	{
+		__m256 x = _mm256_load_ps(block.x + i);
+		__m256 y = _mm256_load_ps(block.y + i);
+		__m256 z = _mm256_load_ps(block.z + i);
+
+		const __m256 height = _mm256_fmadd_ps(x, normalX, _mm256_fmadd_ps(y, normalY, _mm256_mul_ps(z, normalZ)));
+		const __m256 push = _mm256_max_ps(_mm256_sub_ps(surface, height), zero);
+
+		_mm256_store_ps(block.x + i, _mm256_fmadd_ps(normalX, push, x));
+		_mm256_store_ps(block.y + i, _mm256_fmadd_ps(normalY, push, y));
+		_mm256_store_ps(block.z + i, _mm256_fmadd_ps(normalZ, push, z));
+	}
+}
+
+#endif
@@ -0,0 +1,318 @@
+#include <ClothImplicit.hpp>
+
+#include <algorithm>
+#include <math.h>
+#include <stdexcept>
+
+void BlockSparseMatrix::Multiply(const float* x, float* y, ThreadPool& pool) const
+{
+	pool.ParallelFor(GetRowCount(), MIN_BLOCK_ROWS_PER_TASK, [&](size_t begin, size_t end)
+	{
+		for (size_t row = begin; row < end; row++)
+		{
+			glm::vec3 sum(0.0f);
+			for (size_t b = rowStart[row]; b < rowStart[row + 1]; b++)
+			{
+				const float* column = x + columns[b] * 3;
+				sum += blocks[b] * glm::vec3(column[0], column[1], column[2]);
+			}
+
+			y[row * 3] = sum.x;
+			y[row * 3 + 1] = sum.y;
+			y[row * 3 + 2] = sum.z;
+		}
+	});
+}
+
+ClothImplicit::ClothImplicit()
+	:
+	m_kernels(SelectConjugateGradientKernels()),
+	m_residual(0.0f)
+{}
+
+float ClothImplicit::GetResidual() const
+{
+	return m_residual;
+}
+
+void ClothImplicit::Build(const ClothParticles& particles, unsigned int gridRes)
+{
+	m_matrix = BlockSparseMatrix();
+	m_restLengths.clear();
+	m_shear.clear();
+
+	// The diagonal block first, then the 8-neighbourhood in index order
+	m_matrix.rowStart.push_back(0);
+	for (unsigned int y = 0; y < gridRes; y++)
+		for (unsigned int x = 0; x < gridRes; x++)
+		{
+			const unsigned int i = x + y * gridRes;
+			m_matrix.columns.push_back(i);
+			m_restLengths.push_back(0.0f);
+			m_shear.push_back(0);
+
+			for (int dy = -1; dy <= 1; dy++)
+				for (int dx = -1; dx <= 1; dx++)
+				{
+					const int nx = static_cast<int>(x) + dx, ny = static_cast<int>(y) + dy;
+					if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= static_cast<int>(gridRes) || ny >= static_cast<int>(gridRes))
+						continue;
+
+					const unsigned int j = static_cast<unsigned int>(nx) + static_cast<unsigned int>(ny) * gridRes;
+					m_matrix.columns.push_back(j);
+					m_restLengths.push_back(glm::length(particles.GetPosition(j) - particles.GetPosition(i)));
+					m_shear.push_back(dx != 0 && dy != 0);
+				}
+
+			m_matrix.rowStart.push_back(m_matrix.columns.size());
+		}
+
+	m_matrix.blocks.assign(m_matrix.columns.size(), glm::mat3(0.0f));
+}
+
+int ClothImplicit::Step(ClothParticles& particles, const IntegrationTerms& terms, float h, const ClothSolverSettings& settings, ThreadPool& pool)
+{
+	const size_t count = particles.count;
+	m_velocity.resize(count * 3);
+	m_rhs.resize(count * 3);
+
+	// Velocities per unit of time; particles that can't move have none
+	pool.ParallelFor(count, MIN_BLOCK_ROWS_PER_TASK, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const glm::vec3 velocity = particles.invMass[i] != 0.0f ? (particles.GetPosition(i) - particles.GetPrevPosition(i)) / h : glm::vec3(0.0f);
+			m_velocity[i * 3] = velocity.x;
+			m_velocity[i * 3 + 1] = velocity.y;
+			m_velocity[i * 3 + 2] = velocity.z;
+		}
+	});
+
+	m_deltaV.resize(count * 3);
+	Assemble(particles, terms, h, settings, pool);
+
+	const int iterations = SolveConjugateGradient(settings.constraintIterations, settings.tolerance, pool);
+
+	// x' = x + h (v + dv); the old position becomes the previous one, so x' - prev is the new velocity over one step
+	bool finite = true;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (particles.invMass[i] == 0.0f)
+			continue;
+
+		const glm::vec3 position = particles.GetPosition(i);
+		const glm::vec3 velocity(m_velocity[i * 3] + m_deltaV[i * 3], m_velocity[i * 3 + 1] + m_deltaV[i * 3 + 1], m_velocity[i * 3 + 2] + m_deltaV[i * 3 + 2]);
+		const glm::vec3 next = position + velocity * h;
+
+		particles.SetPrevPosition(i, position);
+		particles.SetPosition(i, next);
+
+		finite = finite && isfinite(next.x) && isfinite(next.y) && isfinite(next.z);
+	}
+
+	if (!finite)
+		throw std::runtime_error("implicit integration issue");
+
+	return iterations;
+}
+
+void ClothImplicit::Assemble(const ClothParticles& particles, const IntegrationTerms& terms, float h, const ClothSolverSettings& settings, ThreadPool& pool)
+{
+	const float drag = terms.damping;
+	const glm::mat3 identity(1.0f);
+
+	m_invDiagonal.resize(particles.count * 3);
+
+	// Every row gathers the springs of its own particle, so rows are independent. A spring's blocks come out
+	// bit for bit the same from both of its ends, which keeps the matrix symmetric
+	pool.ParallelFor(particles.count, MIN_BLOCK_ROWS_PER_TASK, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const size_t rowBegin = m_matrix.rowStart[i], rowEnd = m_matrix.rowStart[i + 1];
+			const float invMass = particles.invMass[i];
+
+			// Fixed particles: dv = 0, and their columns meet a zero search direction in every other row
+			if (invMass == 0.0f)
+			{
+				m_matrix.blocks[rowBegin] = identity;
+				for (size_t b = rowBegin + 1; b < rowEnd; b++)
+					m_matrix.blocks[b] = glm::mat3(0.0f);
+
+				for (int c = 0; c < 3; c++)
+				{
+					m_rhs[i * 3 + c] = 0.0f;
+					m_invDiagonal[i * 3 + c] = 1.0f;
+					m_deltaV[i * 3 + c] = 0.0f;
+				}
+				continue;
+			}
+
+			const float mass = 1.0f / invMass;
+			const glm::vec3 position = particles.GetPosition(i);
+			const glm::vec3 velocity(m_velocity[i * 3], m_velocity[i * 3 + 1], m_velocity[i * 3 + 2]);
+
+			// Same wind direction as the integration kernels
+			glm::vec3 wind(0.0f);
+			if (terms.wind != 0.0f)
+			{
+				const uint32_t index = static_cast<uint32_t>(i);
+				wind = glm::vec3(WindComponent(index, terms.windSeed, 0), WindComponent(index, terms.windSeed, 1), WindComponent(index, terms.windSeed, 2));
+
+				const float length = glm::length(wind);
+				wind = length > 0.0f ? wind * (terms.wind / length) : glm::vec3(0.0f);
+			}
+
+			// Drag is integrated implicitly too: -c M v adds h c M to the diagonal
+			glm::mat3 diagonal = identity * (mass * (1.0f + h * drag));
+			glm::vec3 force = mass * (terms.acceleration + wind - drag * velocity);
+			glm::vec3 velocityTerm(0.0f);
+
+			for (size_t b = rowBegin + 1; b < rowEnd; b++)
+			{
+				const unsigned int j = m_matrix.columns[b];
+				const float restLength = m_restLengths[b];
+				const glm::vec3 offset = particles.GetPosition(j) - position;
+				const float distance = glm::length(offset);
+
+				if (!(distance > 0.0f) || !isfinite(distance))
+				{
+					m_matrix.blocks[b] = glm::mat3(0.0f);
+					continue;
+				}
+
+				// Stiffness per unit of relative stretch, so the cloth behaves the same at any resolution
+				const float stiffness = (m_shear[b] ? settings.shearStiffness : settings.stretchStiffness) / restLength;
+				const glm::vec3 direction = offset / distance;
+				const glm::mat3 along = glm::outerProduct(direction, direction);
+
+				// df_i/dx_j. The springs push back when compressed too: a spring without stiffness until it is stretched
+				// would let a long step run straight through its rest length. The transverse part is dropped while compressed,
+				// where it would make the system indefinite
+				const glm::mat3 jacobian = stiffness * (along + std::max(1.0f - restLength / distance, 0.0f) * (identity - along));
+
+				force += stiffness * (distance - restLength) * direction;
+				velocityTerm += jacobian * (glm::vec3(m_velocity[j * 3], m_velocity[j * 3 + 1], m_velocity[j * 3 + 2]) - velocity);
+
+				diagonal += jacobian * (h * h);
+				m_matrix.blocks[b] = jacobian * (-h * h);
+			}
+
+			m_matrix.blocks[rowBegin] = diagonal;
+
+			// First guess: falling freely. Unlike the last step's solution it carries no error over when the iterations run out
+			const glm::vec3 rhs = h * (force + h * velocityTerm);
+			const glm::vec3 guess = h * (terms.acceleration + wind);
+			for (int c = 0; c < 3; c++)
+			{
+				m_rhs[i * 3 + c] = rhs[c];
+				m_invDiagonal[i * 3 + c] = 1.0f / diagonal[c][c];
+				m_deltaV[i * 3 + c] = guess[c];
+			}
+		}
+	});
+}
+
+template <typename Kernel>
+float ClothImplicit::ReduceChunks(const Kernel& kernel, ThreadPool& pool)
+{
+	const size_t count = m_rhs.size();
+	const size_t chunks = (count + CG_CHUNK_SIZE - 1) / CG_CHUNK_SIZE;
+	m_partials.resize(chunks);
+
+	pool.ParallelFor(chunks, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			const size_t first = chunk * CG_CHUNK_SIZE;
+			m_partials[chunk] = kernel(first, std::min(first + CG_CHUNK_SIZE, count) - first);
+		}
+	});
+
+	float sum = 0.0f;
+	for (size_t chunk = 0; chunk < chunks; chunk++)
+		sum += m_partials[chunk];
+
+	return sum;
+}
+
+int ClothImplicit::SolveConjugateGradient(int maxIterations, float tolerance, ThreadPool& pool)
+{
+	const size_t count = m_rhs.size();
+	m_residualVector.resize(count);
+	m_preconditioned.resize(count);
+	m_direction.resize(count);
+	m_product.resize(count);
+
+	float* x = m_deltaV.data();
+	float* r = m_residualVector.data();
+	float* z = m_preconditioned.data();
+	float* p = m_direction.data();
+	float* q = m_product.data();
+	const float* rhs = m_rhs.data();
+	const float* invDiagonal = m_invDiagonal.data();
+
+	// Residuals are measured against the right hand side, so a good first guess needs fewer iterations
+	const float initial = ReduceChunks([&](size_t first, size_t size)
+	{
+		for (size_t k = first; k < first + size; k++)
+			z[k] = invDiagonal[k] * rhs[k];
+
+		return m_kernels.dot(rhs + first, z + first, size);
+	}, pool);
+
+	m_residual = 0.0f;
+	if (!(initial > 0.0f))
+	{
+		m_deltaV.assign(count, 0.0f);
+		return 0;
+	}
+
+	m_matrix.Multiply(x, q, pool);
+	float rz = ReduceChunks([&](size_t first, size_t size)
+	{
+		for (size_t k = first; k < first + size; k++)
+		{
+			r[k] = rhs[k] - q[k];
+			p[k] = z[k] = invDiagonal[k] * r[k];
+		}
+
+		return m_kernels.dot(r + first, z + first, size);
+	}, pool);
+
+	m_residual = sqrtf(std::max(rz, 0.0f) / initial);
+	if (m_residual <= tolerance)
+		return 0;
+
+	int iteration = 0;
+	while (iteration < maxIterations)
+	{
+		m_matrix.Multiply(p, q, pool);
+
+		const float curvature = ReduceChunks([&](size_t first, size_t size) { return m_kernels.dot(p + first, q + first, size); }, pool);
+		if (!(curvature > 0.0f))
+			break;
+
+		const float alpha = rz / curvature;
+		const float nextRz = ReduceChunks([&](size_t first, size_t size)
+		{
+			return m_kernels.step(x + first, r + first, z + first, p + first, q + first, invDiagonal + first, alpha, size);
+		}, pool);
+
+		iteration++;
+		m_residual = sqrtf(std::max(nextRz, 0.0f) / initial);
+		if (m_residual <= tolerance)
+			break;
+
+		const float beta = nextRz / rz;
+		rz = nextRz;
+
+		ReduceChunks([&](size_t first, size_t size)
+		{
+			m_kernels.direction(p + first, z + first, beta, size);
+			return 0.0f;
+		}, pool);
+	}
+
+	return iteration;
+}
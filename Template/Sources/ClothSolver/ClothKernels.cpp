@@ -0,0 +1,214 @@
+#include <ClothKernels.hpp>
+
+#include <math.h>
+
+#ifdef CLOTH_KERNELS_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+ParticleArrays GetParticleArrays(ClothParticles& particles)
+{
+	return { particles.x.data(), particles.y.data(), particles.z.data(),
+		particles.prevX.data(), particles.prevY.data(), particles.prevZ.data(), particles.invMass.data() };
+}
+
+bool IntegrateScalar(ClothParticles& particles, size_t begin, size_t end, const IntegrationTerms& terms)
+{
+	float* x = particles.x.data();
+	float* y = particles.y.data();
+	float* z = particles.z.data();
+	float* prevX = particles.prevX.data();
+	float* prevY = particles.prevY.data();
+	float* prevZ = particles.prevZ.data();
+	const float* invMass = particles.invMass.data();
+
+	const float keep = 1.0f - terms.damping;
+	bool finite = true;
+
+	for (size_t i = begin; i < end; i++)
+	{
+		if (invMass[i] == 0.0f)
+			continue;
+
+		float windX = 0.0f, windY = 0.0f, windZ = 0.0f;
+		if (terms.wind != 0.0f)
+		{
+			const uint32_t index = static_cast<uint32_t>(i);
+			windX = WindComponent(index, terms.windSeed, 0);
+			windY = WindComponent(index, terms.windSeed, 1);
+			windZ = WindComponent(index, terms.windSeed, 2);
+
+			const float length = sqrtf(windX * windX + windY * windY + windZ * windZ);
+			const float scale = length > 0.0f ? terms.wind / length : 0.0f;
+			windX *= scale;
+			windY *= scale;
+			windZ *= scale;
+		}
+
+		const float currentX = x[i], currentY = y[i], currentZ = z[i];
+
+		x[i] = currentX + (currentX - prevX[i]) * keep + (terms.acceleration.x + windX);
+		y[i] = currentY + (currentY - prevY[i]) * keep + (terms.acceleration.y + windY);
+		z[i] = currentZ + (currentZ - prevZ[i]) * keep + (terms.acceleration.z + windZ);
+
+		prevX[i] = currentX;
+		prevY[i] = currentY;
+		prevZ[i] = currentZ;
+
+		finite = finite && isfinite(x[i]) && isfinite(y[i]) && isfinite(z[i]);
+	}
+
+	return finite;
+}
+
+float JacobiScalar(const JacobiTerms& terms, size_t row)
+{
+	const size_t gridRes = terms.gridRes;
+	const size_t begin = row * gridRes;
+
+	// Missing neighbours point back at the particle, their links have no rest length
+	const size_t up = row > 0 ? begin - gridRes : begin;
+	const size_t down = row + 1 < gridRes ? begin + gridRes : begin;
+
+	float stretch = 0.0f;
+	for (size_t x = 0; x < gridRes; x++)
+	{
+		const size_t i = begin + x;
+		stretch = fmaxf(stretch, JacobiParticle(terms, i, x > 0 ? i - 1 : i, x + 1 < gridRes ? i + 1 : i, up + x, down + x));
+	}
+
+	return stretch;
+}
+
+float DotScalar(const float* a, const float* b, size_t count)
+{
+	float sum = 0.0f;
+	for (size_t i = 0; i < count; i++)
+		sum += a[i] * b[i];
+
+	return sum;
+}
+
+float ConjugateGradientStepScalar(float* x, float* r, float* z, const float* p, const float* q, const float* invDiagonal, float alpha, size_t count)
+{
+	float rz = 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		x[i] += alpha * p[i];
+		r[i] -= alpha * q[i];
+		z[i] = invDiagonal[i] * r[i];
+		rz += r[i] * z[i];
+	}
+
+	return rz;
+}
+
+void ConjugateGradientDirectionScalar(float* p, const float* z, float beta, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		p[i] = z[i] + beta * p[i];
+}
+
+#ifdef CLOTH_KERNELS_X86
+bool CpuSupports(bool avx2)
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	const bool sse41 = (info[2] & (1 << 19)) != 0;
+	if (!avx2)
+		return sse41;
+
+	const bool fma = (info[2] & (1 << 12)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (!fma || !osxsave || maxLeaf < 7)
+		return false;
+
+	// The OS has to save the YMM registers on context switches
+	if ((_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	if (!avx2)
+		return __builtin_cpu_supports("sse4.1");
+
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+#endif
+
+IntegrationKernel SelectIntegrationKernel()
+{
+	static const IntegrationKernel kernel = []() -> IntegrationKernel
+	{
+#ifdef CLOTH_KERNELS_X86
+		if (CpuSupports(true))
+			return IntegrateAVX2;
+		if (CpuSupports(false))
+			return IntegrateSSE;
+#endif
+		return IntegrateScalar;
+	}();
+
+	return kernel;
+}
+
+const char* GetIntegrationKernelName(IntegrationKernel kernel)
+{
+#ifdef CLOTH_KERNELS_X86
+	if (kernel == IntegrateAVX2)
+		return "AVX2";
+	if (kernel == IntegrateSSE)
+		return "SSE4.1";
+#endif
+	return "Scalar";
+}
+
+JacobiKernel SelectJacobiKernel()
+{
+#ifdef CLOTH_KERNELS_X86
+	if (SelectIntegrationKernel() == IntegrateAVX2)
+		return JacobiAVX2;
+#endif
+	return JacobiScalar;
+}
+
+const char* GetJacobiKernelName(JacobiKernel kernel)
+{
+#ifdef CLOTH_KERNELS_X86
+	if (kernel == JacobiAVX2)
+		return "AVX2";
+#endif
+	return "Scalar";
+}
+
+const ConjugateGradientKernels& GetScalarConjugateGradientKernels()
+{
+	static const ConjugateGradientKernels kernels = { DotScalar, ConjugateGradientStepScalar, ConjugateGradientDirectionScalar, "Scalar" };
+	return kernels;
+}
+
+#ifdef CLOTH_KERNELS_X86
+const ConjugateGradientKernels& GetAVX2ConjugateGradientKernels()
+{
+	static const ConjugateGradientKernels kernels = { DotAVX2, ConjugateGradientStepAVX2, ConjugateGradientDirectionAVX2, "AVX2" };
+	return kernels;
+}
+#endif
+
+const ConjugateGradientKernels& SelectConjugateGradientKernels()
+{
+#ifdef CLOTH_KERNELS_X86
+	if (SelectIntegrationKernel() == IntegrateAVX2)
+		return GetAVX2ConjugateGradientKernels();
+#endif
+	return GetScalarConjugateGradientKernels();
+}
@@ -0,0 +1,246 @@
+// Built with AVX2 + FMA code generation, only called after SelectIntegrationKernel() checked the CPU
+#include <ClothKernels.hpp>
+
+#ifdef CLOTH_KERNELS_X86
+#include <immintrin.h>
+
+static inline __m256i WindHash8(__m256i h)
+{
+	h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+	h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(0x85EBCA6Bu)));
+	h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+	h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(0xC2B2AE35u)));
+	h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+	return h;
+}
+
+// Same as WindComponent() for 8 consecutive particles; index3 holds i * 3
+static inline __m256 WindComponent8(__m256i index3, uint32_t seed, uint32_t component)
+{
+	const __m256i h = WindHash8(_mm256_add_epi32(index3, _mm256_set1_epi32(static_cast<int>(component + seed * 0x9E3779B1u))));
+	const __m256 value = _mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8));
+	return _mm256_sub_ps(_mm256_mul_ps(value, _mm256_set1_ps(1.0f / 8388608.0f)), _mm256_set1_ps(1.0f));
+}
+
+bool IntegrateAVX2(ClothParticles& particles, size_t begin, size_t end, const IntegrationTerms& terms)
+{
+	const ParticleArrays arrays = GetParticleArrays(particles);
+	float* x = arrays.x;
+	float* y = arrays.y;
+	float* z = arrays.z;
+	float* prevX = arrays.prevX;
+	float* prevY = arrays.prevY;
+	float* prevZ = arrays.prevZ;
+	const float* invMass = arrays.invMass;
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 keep = _mm256_set1_ps(1.0f - terms.damping);
+	const __m256 accelerationX = _mm256_set1_ps(terms.acceleration.x);
+	const __m256 accelerationY = _mm256_set1_ps(terms.acceleration.y);
+	const __m256 accelerationZ = _mm256_set1_ps(terms.acceleration.z);
+	const __m256 wind = _mm256_set1_ps(terms.wind);
+	const bool hasWind = terms.wind != 0.0f;
+
+	__m256 nonFinite = zero;
+
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8)
+	{
+		const __m256 active = _mm256_cmp_ps(_mm256_loadu_ps(invMass + i), zero, _CMP_NEQ_OQ);
+		if (_mm256_movemask_ps(active) == 0)
+			continue;
+
+		__m256 stepX = accelerationX, stepY = accelerationY, stepZ = accelerationZ;
+		if (hasWind)
+		{
+			const __m256i index3 = _mm256_mullo_epi32(
+				_mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)),
+				_mm256_set1_epi32(3));
+
+			const __m256 windX = WindComponent8(index3, terms.windSeed, 0);
+			const __m256 windY = WindComponent8(index3, terms.windSeed, 1);
+			const __m256 windZ = WindComponent8(index3, terms.windSeed, 2);
+
+			const __m256 length = _mm256_sqrt_ps(_mm256_fmadd_ps(windX, windX, _mm256_fmadd_ps(windY, windY, _mm256_mul_ps(windZ, windZ))));
+			const __m256 scale = _mm256_and_ps(_mm256_cmp_ps(length, zero, _CMP_GT_OQ), _mm256_div_ps(wind, length));
+
+			stepX = _mm256_fmadd_ps(windX, scale, stepX);
+			stepY = _mm256_fmadd_ps(windY, scale, stepY);
+			stepZ = _mm256_fmadd_ps(windZ, scale, stepZ);
+		}
+
+		const __m256 currentX = _mm256_loadu_ps(x + i);
+		const __m256 currentY = _mm256_loadu_ps(y + i);
+		const __m256 currentZ = _mm256_loadu_ps(z + i);
+		const __m256 oldX = _mm256_loadu_ps(prevX + i);
+		const __m256 oldY = _mm256_loadu_ps(prevY + i);
+		const __m256 oldZ = _mm256_loadu_ps(prevZ + i);
+
+		const __m256 newX = _mm256_fmadd_ps(_mm256_sub_ps(currentX, oldX), keep, _mm256_add_ps(currentX, stepX));
+		const __m256 newY = _mm256_fmadd_ps(_mm256_sub_ps(currentY, oldY), keep, _mm256_add_ps(currentY, stepY));
+		const __m256 newZ = _mm256_fmadd_ps(_mm256_sub_ps(currentZ, oldZ), keep, _mm256_add_ps(currentZ, stepZ));
+
+		_mm256_storeu_ps(x + i, _mm256_blendv_ps(currentX, newX, active));
+		_mm256_storeu_ps(y + i, _mm256_blendv_ps(currentY, newY, active));
+		_mm256_storeu_ps(z + i, _mm256_blendv_ps(currentZ, newZ, active));
+		_mm256_storeu_ps(prevX + i, _mm256_blendv_ps(oldX, currentX, active));
+		_mm256_storeu_ps(prevY + i, _mm256_blendv_ps(oldY, currentY, active));
+		_mm256_storeu_ps(prevZ + i, _mm256_blendv_ps(oldZ, currentZ, active));
+
+		// v - v is NaN exactly when v is infinite or NaN
+		__m256 invalid = _mm256_cmp_ps(_mm256_sub_ps(newX, newX), zero, _CMP_NEQ_UQ);
+		invalid = _mm256_or_ps(invalid, _mm256_cmp_ps(_mm256_sub_ps(newY, newY), zero, _CMP_NEQ_UQ));
+		invalid = _mm256_or_ps(invalid, _mm256_cmp_ps(_mm256_sub_ps(newZ, newZ), zero, _CMP_NEQ_UQ));
+		nonFinite = _mm256_or_ps(nonFinite, _mm256_and_ps(invalid, active));
+	}
+
+	const bool tailFinite = IntegrateScalar(particles, i, end, terms);
+
+	return tailFinite && _mm256_movemask_ps(nonFinite) == 0;
+}
+
+// One link of JacobiParticle() for 8 particles: adds its correction and pull to the sums where it is stretched
+static inline void AccumulateLink8(const JacobiTerms& terms, size_t j, const float* rest, __m256 px, __m256 py, __m256 pz, __m256 w, __m256 active,
+	__m256& sumX, __m256& sumY, __m256& sumZ, __m256& pulled, __m256& stretch)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 infinity = _mm256_set1_ps(INFINITY);
+
+	const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(terms.x + j), px);
+	const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(terms.y + j), py);
+	const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(terms.z + j), pz);
+	const __m256 distance = _mm256_sqrt_ps(_mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz))));
+	const __m256 restLength = _mm256_mul_ps(_mm256_loadu_ps(rest), _mm256_set1_ps(terms.slack));
+
+	// Lanes without a stretched link get nothing, which also masks the divisions by zero
+	__m256 stretched = _mm256_and_ps(_mm256_cmp_ps(restLength, _mm256_setzero_ps(), _CMP_GT_OQ), _mm256_cmp_ps(distance, restLength, _CMP_GT_OQ));
+	stretched = _mm256_and_ps(_mm256_and_ps(stretched, _mm256_cmp_ps(distance, infinity, _CMP_LT_OQ)), active);
+
+	const __m256 share = _mm256_div_ps(w, _mm256_add_ps(w, _mm256_loadu_ps(terms.invMass + j)));
+	const __m256 scale = _mm256_and_ps(stretched, _mm256_mul_ps(_mm256_sub_ps(one, _mm256_div_ps(restLength, distance)), share));
+
+	sumX = _mm256_fmadd_ps(dx, scale, sumX);
+	sumY = _mm256_fmadd_ps(dy, scale, sumY);
+	sumZ = _mm256_fmadd_ps(dz, scale, sumZ);
+	pulled = _mm256_add_ps(pulled, _mm256_and_ps(stretched, one));
+	stretch = _mm256_max_ps(stretch, _mm256_and_ps(stretched, _mm256_sub_ps(_mm256_div_ps(distance, restLength), one)));
+}
+
+float JacobiAVX2(const JacobiTerms& terms, size_t row)
+{
+	const size_t gridRes = terms.gridRes;
+	const size_t begin = row * gridRes;
+	const size_t up = row > 0 ? begin - gridRes : begin;
+	const size_t down = row + 1 < gridRes ? begin + gridRes : begin;
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 omega = _mm256_set1_ps(terms.omega);
+
+	// The row ends have a missing neighbour, the scalar version handles those
+	float stretch = JacobiParticle(terms, begin, begin, gridRes > 1 ? begin + 1 : begin, up, down);
+	__m256 stretch8 = zero;
+
+	size_t x = 1;
+	for (; x + 8 < gridRes; x += 8)
+	{
+		const size_t i = begin + x;
+
+		const __m256 px = _mm256_loadu_ps(terms.x + i);
+		const __m256 py = _mm256_loadu_ps(terms.y + i);
+		const __m256 pz = _mm256_loadu_ps(terms.z + i);
+
+		const __m256 w = _mm256_loadu_ps(terms.invMass + i);
+		const __m256 active = _mm256_cmp_ps(w, zero, _CMP_NEQ_OQ);
+		if (_mm256_movemask_ps(active) == 0)
+		{
+			_mm256_storeu_ps(terms.outX + i, px);
+			_mm256_storeu_ps(terms.outY + i, py);
+			_mm256_storeu_ps(terms.outZ + i, pz);
+			continue;
+		}
+
+		__m256 sumX = zero, sumY = zero, sumZ = zero, pulled = zero;
+		AccumulateLink8(terms, i - 1, terms.restLeft + i, px, py, pz, w, active, sumX, sumY, sumZ, pulled, stretch8);
+		AccumulateLink8(terms, i + 1, terms.restRight + i, px, py, pz, w, active, sumX, sumY, sumZ, pulled, stretch8);
+		AccumulateLink8(terms, up + x, terms.restUp + i, px, py, pz, w, active, sumX, sumY, sumZ, pulled, stretch8);
+		AccumulateLink8(terms, down + x, terms.restDown + i, px, py, pz, w, active, sumX, sumY, sumZ, pulled, stretch8);
+
+		const __m256 average = _mm256_and_ps(_mm256_cmp_ps(pulled, zero, _CMP_GT_OQ), _mm256_div_ps(one, pulled));
+		const __m256 jacobiX = _mm256_fmadd_ps(sumX, average, px);
+		const __m256 jacobiY = _mm256_fmadd_ps(sumY, average, py);
+		const __m256 jacobiZ = _mm256_fmadd_ps(sumZ, average, pz);
+
+		const __m256 lastX = _mm256_loadu_ps(terms.lastX + i);
+		const __m256 lastY = _mm256_loadu_ps(terms.lastY + i);
+		const __m256 lastZ = _mm256_loadu_ps(terms.lastZ + i);
+
+		_mm256_storeu_ps(terms.outX + i, _mm256_blendv_ps(px, _mm256_fmadd_ps(omega, _mm256_sub_ps(jacobiX, lastX), lastX), active));
+		_mm256_storeu_ps(terms.outY + i, _mm256_blendv_ps(py, _mm256_fmadd_ps(omega, _mm256_sub_ps(jacobiY, lastY), lastY), active));
+		_mm256_storeu_ps(terms.outZ + i, _mm256_blendv_ps(pz, _mm256_fmadd_ps(omega, _mm256_sub_ps(jacobiZ, lastZ), lastZ), active));
+	}
+
+	for (; x < gridRes; x++)
+	{
+		const size_t i = begin + x;
+		stretch = fmaxf(stretch, JacobiParticle(terms, i, i - 1, x + 1 < gridRes ? i + 1 : i, up + x, down + x));
+	}
+
+	alignas(32) float lanes[8];
+	_mm256_store_ps(lanes, stretch8);
+	for (int lane = 0; lane < 8; lane++)
+		stretch = fmaxf(stretch, lanes[lane]);
+
+	return stretch;
+}
+
+// Sum of the 8 lanes
+static inline float HorizontalSum(__m256 v)
+{
+	const __m128 half = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	const __m128 pairs = _mm_add_ps(half, _mm_movehl_ps(half, half));
+	return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+}
+
+float DotAVX2(const float* a, const float* b, size_t count)
+{
+	__m256 sum = _mm256_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		sum = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum);
+
+	return HorizontalSum(sum) + DotScalar(a + i, b + i, count - i);
+}
+
+float ConjugateGradientStepAVX2(float* x, float* r, float* z, const float* p, const float* q, const float* invDiagonal, float alpha, size_t count)
+{
+	const __m256 alpha8 = _mm256_set1_ps(alpha);
+	__m256 rz = _mm256_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 residual = _mm256_fnmadd_ps(alpha8, _mm256_loadu_ps(q + i), _mm256_loadu_ps(r + i));
+		const __m256 preconditioned = _mm256_mul_ps(_mm256_loadu_ps(invDiagonal + i), residual);
+
+		_mm256_storeu_ps(x + i, _mm256_fmadd_ps(alpha8, _mm256_loadu_ps(p + i), _mm256_loadu_ps(x + i)));
+		_mm256_storeu_ps(r + i, residual);
+		_mm256_storeu_ps(z + i, preconditioned);
+		rz = _mm256_fmadd_ps(residual, preconditioned, rz);
+	}
+
+	return HorizontalSum(rz) + ConjugateGradientStepScalar(x + i, r + i, z + i, p + i, q + i, invDiagonal + i, alpha, count - i);
+}
+
+void ConjugateGradientDirectionAVX2(float* p, const float* z, float beta, size_t count)
+{
+	const __m256 beta8 = _mm256_set1_ps(beta);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(p + i, _mm256_fmadd_ps(beta8, _mm256_loadu_ps(p + i), _mm256_loadu_ps(z + i)));
+
+	ConjugateGradientDirectionScalar(p + i, z + i, beta, count - i);
+}
+#endif
@@ -0,0 +1,107 @@
+// Built with SSE4.1 code generation, only called after SelectIntegrationKernel() checked the CPU
+#include <ClothKernels.hpp>
+
+#ifdef CLOTH_KERNELS_X86
+#include <smmintrin.h>
+
+static inline __m128i WindHash4(__m128i h)
+{
+	h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+	h = _mm_mullo_epi32(h, _mm_set1_epi32(static_cast<int>(0x85EBCA6Bu)));
+	h = _mm_xor_si128(h, _mm_srli_epi32(h, 13));
+	h = _mm_mullo_epi32(h, _mm_set1_epi32(static_cast<int>(0xC2B2AE35u)));
+	h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+	return h;
+}
+
+// No FMA before AVX2
+static inline __m128 MulAdd(__m128 a, __m128 b, __m128 c)
+{
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+// Same as WindComponent() for 4 consecutive particles; index3 holds i * 3
+static inline __m128 WindComponent4(__m128i index3, uint32_t seed, uint32_t component)
+{
+	const __m128i h = WindHash4(_mm_add_epi32(index3, _mm_set1_epi32(static_cast<int>(component + seed * 0x9E3779B1u))));
+	const __m128 value = _mm_cvtepi32_ps(_mm_srli_epi32(h, 8));
+	return _mm_sub_ps(_mm_mul_ps(value, _mm_set1_ps(1.0f / 8388608.0f)), _mm_set1_ps(1.0f));
+}
+
+bool IntegrateSSE(ClothParticles& particles, size_t begin, size_t end, const IntegrationTerms& terms)
+{
+	const ParticleArrays arrays = GetParticleArrays(particles);
+	float* x = arrays.x;
+	float* y = arrays.y;
+	float* z = arrays.z;
+	float* prevX = arrays.prevX;
+	float* prevY = arrays.prevY;
+	float* prevZ = arrays.prevZ;
+	const float* invMass = arrays.invMass;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 keep = _mm_set1_ps(1.0f - terms.damping);
+	const __m128 accelerationX = _mm_set1_ps(terms.acceleration.x);
+	const __m128 accelerationY = _mm_set1_ps(terms.acceleration.y);
+	const __m128 accelerationZ = _mm_set1_ps(terms.acceleration.z);
+	const __m128 wind = _mm_set1_ps(terms.wind);
+	const bool hasWind = terms.wind != 0.0f;
+
+	__m128 nonFinite = zero;
+
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4)
+	{
+		const __m128 active = _mm_cmpneq_ps(_mm_loadu_ps(invMass + i), zero);
+		if (_mm_movemask_ps(active) == 0)
+			continue;
+
+		__m128 stepX = accelerationX, stepY = accelerationY, stepZ = accelerationZ;
+		if (hasWind)
+		{
+			const __m128i index3 = _mm_mullo_epi32(
+				_mm_add_epi32(_mm_set1_epi32(static_cast<int>(i)), _mm_setr_epi32(0, 1, 2, 3)),
+				_mm_set1_epi32(3));
+
+			const __m128 windX = WindComponent4(index3, terms.windSeed, 0);
+			const __m128 windY = WindComponent4(index3, terms.windSeed, 1);
+			const __m128 windZ = WindComponent4(index3, terms.windSeed, 2);
+
+			const __m128 length = _mm_sqrt_ps(MulAdd(windX, windX, MulAdd(windY, windY, _mm_mul_ps(windZ, windZ))));
+			const __m128 scale = _mm_and_ps(_mm_cmpgt_ps(length, zero), _mm_div_ps(wind, length));
+
+			stepX = MulAdd(windX, scale, stepX);
+			stepY = MulAdd(windY, scale, stepY);
+			stepZ = MulAdd(windZ, scale, stepZ);
+		}
+
+		const __m128 currentX = _mm_loadu_ps(x + i);
+		const __m128 currentY = _mm_loadu_ps(y + i);
+		const __m128 currentZ = _mm_loadu_ps(z + i);
+		const __m128 oldX = _mm_loadu_ps(prevX + i);
+		const __m128 oldY = _mm_loadu_ps(prevY + i);
+		const __m128 oldZ = _mm_loadu_ps(prevZ + i);
+
+		const __m128 newX = MulAdd(_mm_sub_ps(currentX, oldX), keep, _mm_add_ps(currentX, stepX));
+		const __m128 newY = MulAdd(_mm_sub_ps(currentY, oldY), keep, _mm_add_ps(currentY, stepY));
+		const __m128 newZ = MulAdd(_mm_sub_ps(currentZ, oldZ), keep, _mm_add_ps(currentZ, stepZ));
+
+		_mm_storeu_ps(x + i, _mm_blendv_ps(currentX, newX, active));
+		_mm_storeu_ps(y + i, _mm_blendv_ps(currentY, newY, active));
+		_mm_storeu_ps(z + i, _mm_blendv_ps(currentZ, newZ, active));
+		_mm_storeu_ps(prevX + i, _mm_blendv_ps(oldX, currentX, active));
+		_mm_storeu_ps(prevY + i, _mm_blendv_ps(oldY, currentY, active));
+		_mm_storeu_ps(prevZ + i, _mm_blendv_ps(oldZ, currentZ, active));
+
+		// v - v is NaN exactly when v is infinite or NaN
+		__m128 invalid = _mm_cmpneq_ps(_mm_sub_ps(newX, newX), zero);
+		invalid = _mm_or_ps(invalid, _mm_cmpneq_ps(_mm_sub_ps(newY, newY), zero));
+		invalid = _mm_or_ps(invalid, _mm_cmpneq_ps(_mm_sub_ps(newZ, newZ), zero));
+		nonFinite = _mm_or_ps(nonFinite, _mm_and_ps(invalid, active));
+	}
+
+	const bool tailFinite = IntegrateScalar(particles, i, end, terms);
+
+	return tailFinite && _mm_movemask_ps(nonFinite) == 0;
+}
+#endif
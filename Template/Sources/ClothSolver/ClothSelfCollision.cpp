@@ -0,0 +1,179 @@
+#include <ClothSelfCollision.hpp>
+#include <ClothSolver.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <stdlib.h>
+
+ClothSelfCollision::ClothSelfCollision()
+	:
+	m_cellSize(0.0f),
+	m_inverseCellSize(0.0f),
+	m_bucketMask(0),
+	m_rebuilt(false)
+{}
+
+bool ClothSelfCollision::WasRebuilt() const
+{
+	return m_rebuilt;
+}
+
+size_t ClothSelfCollision::Solve(ClothParticles& particles, unsigned int gridRes, float thickness, ThreadPool& pool)
+{
+	m_rebuilt = false;
+	if (thickness <= 0.0f || particles.count == 0)
+		return 0;
+
+	// Cells twice the thickness: every contact of a particle lies in the 2x2x2 cells on its side of its own cell
+	if (2.0f * thickness != m_cellSize)
+	{
+		m_cellSize = 2.0f * thickness;
+		m_inverseCellSize = 1.0f / m_cellSize;
+		m_particleKeys.clear();
+	}
+
+	UpdateBuckets(particles, pool);
+
+	const size_t count = particles.count;
+	m_deltas.resize(count);
+	m_contacts.resize(count);
+
+	const float thicknessSquared = thickness * thickness;
+	std::atomic<size_t> contacts(0);
+
+	// Every particle sums its own share of the push from all of its contacts, and only writes its own entry
+	pool.ParallelFor(count, MIN_COLLISION_PARTICLES_PER_TASK, [&](size_t begin, size_t end)
+	{
+		size_t chunkContacts = 0;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			glm::vec3 delta(0.0f);
+			uint32_t contactCount = 0;
+
+			// Pinned and sleeping particles don't move, their neighbours take the whole push
+			const float wI = particles.invMass[i];
+			if (wI != 0.0f)
+			{
+				const glm::vec3 position = particles.GetPosition(i);
+				const glm::vec3 scaled = position * m_inverseCellSize;
+				const glm::vec3 cellPosition = glm::floor(scaled);
+				const glm::ivec3 cell(cellPosition);
+
+				// The lower or upper neighbour along each axis, whichever half of the cell the particle is in
+				const glm::ivec3 side = glm::ivec3(glm::greaterThanEqual(scaled - cellPosition, glm::vec3(0.5f))) * 2 - 1;
+
+				const uint32_t hashX[2] = { HashX(cell.x), HashX(cell.x + side.x) };
+				const uint32_t hashY[2] = { HashY(cell.y), HashY(cell.y + side.y) };
+				const uint32_t hashZ[2] = { HashZ(cell.z), HashZ(cell.z + side.z) };
+
+				for (int z = 0; z < 2; z++)
+					for (int y = 0; y < 2; y++)
+						for (int x = 0; x < 2; x++)
+						{
+							const uint32_t key = hashX[x] ^ hashY[y] ^ hashZ[z];
+							const uint32_t bucket = key & m_bucketMask;
+
+							for (uint32_t k = m_bucketStart[bucket]; k < m_bucketStart[bucket + 1]; k++)
+							{
+								// Entries of other cells sharing the bucket are seen when that cell is visited
+								if (m_bucketKeys[k] != key)
+									continue;
+
+								const uint32_t j = m_bucketParticles[k];
+								const glm::vec3 offset = position - particles.GetPosition(j);
+								const float distanceSquared = glm::dot(offset, offset);
+								if (distanceSquared >= thicknessSquared || distanceSquared == 0.0f)
+									continue;
+
+								if (abs(static_cast<int>(j % gridRes) - static_cast<int>(i % gridRes)) <= 1
+									&& abs(static_cast<int>(j / gridRes) - static_cast<int>(i / gridRes)) <= 1)
+									continue;
+
+								const float distance = sqrtf(distanceSquared);
+								const float wJ = particles.invMass[j];
+								delta += offset * ((thickness - distance) / distance * wI / (wI + wJ));
+								contactCount++;
+							}
+						}
+			}
+
+			m_deltas[i] = delta;
+			m_contacts[i] = contactCount;
+			chunkContacts += contactCount;
+		}
+
+		contacts += chunkContacts;
+	});
+
+	if (contacts.load() == 0)
+		return 0;
+
+	// Average the pushes, so a particle squeezed from many sides doesn't overshoot
+	pool.ParallelFor(count, MIN_PARTICLES_PER_TASK, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			if (m_contacts[i] != 0)
+				particles.SetPosition(i, particles.GetPosition(i) + m_deltas[i] / static_cast<float>(m_contacts[i]));
+	});
+
+	return contacts.load();
+}
+
+void ClothSelfCollision::UpdateBuckets(const ClothParticles& particles, ThreadPool& pool)
+{
+	const size_t count = particles.count;
+
+	// Twice as many buckets as particles keeps hash collisions rare
+	size_t bucketCount = 1;
+	while (bucketCount < 2 * count)
+		bucketCount <<= 1;
+
+	bool resized = m_particleKeys.size() != count || m_bucketStart.size() != bucketCount + 1;
+	if (resized)
+		m_particleKeys.assign(count, 0);
+	m_bucketMask = static_cast<uint32_t>(bucketCount - 1);
+
+	std::atomic<bool> moved(false);
+	pool.ParallelFor(count, MIN_PARTICLES_PER_TASK, [&](size_t begin, size_t end)
+	{
+		bool chunkMoved = false;
+		for (size_t i = begin; i < end; i++)
+		{
+			const glm::ivec3 cell = GetCell(particles.GetPosition(i));
+			const uint32_t key = HashX(cell.x) ^ HashY(cell.y) ^ HashZ(cell.z);
+			if (key != m_particleKeys[i])
+			{
+				m_particleKeys[i] = key;
+				chunkMoved = true;
+			}
+		}
+
+		if (chunkMoved)
+			moved = true;
+	});
+
+	// Nobody changed cell, the sorted buckets from last time still hold
+	m_rebuilt = resized || moved.load();
+	if (!m_rebuilt)
+		return;
+
+	// Counting sort: bucket sizes, prefix sums, scatter in particle order
+	m_bucketStart.assign(bucketCount + 1, 0);
+	for (size_t i = 0; i < count; i++)
+		m_bucketStart[(m_particleKeys[i] & m_bucketMask) + 1]++;
+
+	for (size_t b = 0; b < bucketCount; b++)
+		m_bucketStart[b + 1] += m_bucketStart[b];
+
+	m_bucketFill.assign(m_bucketStart.begin(), m_bucketStart.end() - 1);
+	m_bucketParticles.resize(count);
+	m_bucketKeys.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		const uint32_t entry = m_bucketFill[m_particleKeys[i] & m_bucketMask]++;
+		m_bucketParticles[entry] = static_cast<uint32_t>(i);
+		m_bucketKeys[entry] = m_particleKeys[i];
+	}
+}
@@ -0,0 +1,105 @@
+#include <ClothSimThread.hpp>
+
+#include <stdexcept>
+
+ClothSimThread::ClothSimThread(ClothWorld& world)
+	:
+	m_world(world),
+	m_busy(false),
+	m_pending(false),
+	m_quit(false),
+	m_front(0),
+	m_thread(&ClothSimThread::WorkerLoop, this)
+{}
+
+ClothSimThread::~ClothSimThread()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_wake.wait(lock, [&] { return !m_busy; });
+		m_quit = true;
+	}
+	m_wake.notify_all();
+
+	m_thread.join();
+}
+
+void ClothSimThread::Submit(const ClothSimJob& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_busy)
+			throw std::logic_error("a cloth simulation job is already running");
+
+		m_job = job;
+		m_busy = true;
+		m_pending = true;
+	}
+	m_wake.notify_all();
+}
+
+const ClothSimFrame& ClothSimThread::Sync()
+{
+	bool finished;
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_wake.wait(lock, [&] { return !m_busy; });
+
+		finished = m_pending;
+		m_pending = false;
+
+		error = m_error;
+		m_error = nullptr;
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+
+	// The worker only writes the back frame while busy, so it can be swapped in without the lock
+	if (finished)
+		m_front = 1 - m_front;
+
+	return m_frames[m_front];
+}
+
+void ClothSimThread::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_wake.wait(lock, [&] { return m_busy || m_quit; });
+		if (m_quit)
+			return;
+
+		// The render thread doesn't touch the job or the back frame until it is done
+		lock.unlock();
+
+		std::exception_ptr error;
+		try
+		{
+			ClothSimFrame& frame = m_frames[1 - m_front];
+			frame.steps = m_world.Advance(m_job.forceFields, m_job.colliders, m_job.modelMatrices, m_job.frameTime, m_job.rate, m_job.maxSteps);
+			frame.stats = m_world.GetStats();
+
+			const float alpha = m_job.interpolate ? m_world.GetInterpolation() : 1.0f;
+			frame.positions.resize(m_world.GetClothCount());
+			frame.normals.resize(m_world.GetClothCount());
+			for (size_t i = 0; i < frame.positions.size(); i++)
+			{
+				m_world.GetInterpolatedPositions(i, alpha, frame.positions[i]);
+				m_world.GetCloth(i).ComputeNormals(frame.positions[i], frame.normals[i]);
+			}
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		lock.lock();
+		m_error = error;
+		m_busy = false;
+		m_wake.notify_all();
+	}
+}
@@ -0,0 +1,1558 @@
+#include <ClothSolver.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+/// <summary>
+/// Pull the two particles of a stretched link back towards its rest length times slack.
+/// The correction is split by inverse mass, so pinned particles never move.
+/// Returns the relative stretch found before the correction, 0 for links that are not too long
+/// </summary>
+static inline float SolveDistanceConstraint(ClothParticles& particles, const DistanceConstraint& constraint, float slack)
+{
+	const unsigned int i = constraint.i;
+	const unsigned int j = constraint.j;
+
+	const float dx = particles.x[j] - particles.x[i];
+	const float dy = particles.y[j] - particles.y[i];
+	const float dz = particles.z[j] - particles.z[i];
+
+	const float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+	if (!isfinite(distance))
+	{
+		// Not clamped: a link with a non-finite length has no direction to pull along, and a clamped correction would
+		// only carry the bad value over to the other end. The first particle goes back to where it was before the step
+		// instead; if the cloth stays non-finite, the check after the next integration throws
+		if (particles.invMass[i] != 0.0f)
+			particles.SetPosition(i, particles.GetPrevPosition(i));
+		return 0.0f;
+	}
+
+	const float restLength = constraint.restLength * slack;
+	if (distance > restLength)
+	{
+		// Pull vertices closer, exactly back to the rest length: scaling by the stretch itself would overshoot
+		// by distance / restLength, which throws badly stretched links past each other
+		const float stretch = distance / restLength - 1.0f;
+		const float correction = 1.0f - restLength / distance;
+		const float wI = particles.invMass[i];
+		const float wJ = particles.invMass[j];
+		const float scaleI = correction * wI / (wI + wJ);
+		const float scaleJ = correction * wJ / (wI + wJ);
+
+		particles.x[i] += dx * scaleI;
+		particles.y[i] += dy * scaleI;
+		particles.z[i] += dz * scaleI;
+
+		particles.x[j] -= dx * scaleJ;
+		particles.y[j] -= dy * scaleJ;
+		particles.z[j] -= dz * scaleJ;
+
+		return stretch;
+	}
+
+	return 0.0f;
+}
+
+/// <summary>
+/// XPBD version of SolveDistanceConstraint(): the link's multiplier lambda grows by the correction, which is damped by
+/// compliance (already divided by the squared substep time). Links only pull, so lambda never turns positive.
+/// Returns the relative stretch found before the correction
+/// </summary>
+static inline float SolveCompliantConstraint(ClothParticles& particles, const DistanceConstraint& constraint, float slack, float compliance, float& lambda)
+{
+	const unsigned int i = constraint.i;
+	const unsigned int j = constraint.j;
+
+	const float dx = particles.x[j] - particles.x[i];
+	const float dy = particles.y[j] - particles.y[i];
+	const float dz = particles.z[j] - particles.z[i];
+
+	const float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+	if (!isfinite(distance) || distance == 0.0f)
+		return 0.0f;
+
+	const float restLength = constraint.restLength * slack;
+	const float stretch = distance - restLength;
+
+	const float wI = particles.invMass[i];
+	const float wJ = particles.invMass[j];
+	const float newLambda = std::min(lambda + (-stretch - compliance * lambda) / (wI + wJ + compliance), 0.0f);
+	const float deltaLambda = newLambda - lambda;
+	lambda = newLambda;
+
+	if (deltaLambda == 0.0f)
+		return 0.0f;
+
+	// Along the unit direction from i to j
+	const float scale = deltaLambda / distance;
+	particles.x[i] -= dx * scale * wI;
+	particles.y[i] -= dy * scale * wI;
+	particles.z[i] -= dz * scale * wI;
+
+	particles.x[j] += dx * scale * wJ;
+	particles.y[j] += dy * scale * wJ;
+	particles.z[j] += dz * scale * wJ;
+
+	return std::max(stretch / restLength, 0.0f);
+}
+
+/// <summary>
+/// Grid rectangle [x0, x1) x [y0, y1) covered by a sleep tile
+/// </summary>
+static inline void GetTileRect(size_t tile, unsigned int tilesX, unsigned int gridRes,
+	unsigned int& x0, unsigned int& x1, unsigned int& y0, unsigned int& y1)
+{
+	x0 = static_cast<unsigned int>(tile % tilesX) * SLEEP_TILE_SIZE;
+	y0 = static_cast<unsigned int>(tile / tilesX) * SLEEP_TILE_SIZE;
+	x1 = std::min(x0 + SLEEP_TILE_SIZE, gridRes);
+	y1 = std::min(y0 + SLEEP_TILE_SIZE, gridRes);
+}
+
+static inline bool Overlaps(glm::vec3 minA, glm::vec3 maxA, glm::vec3 minB, glm::vec3 maxB)
+{
+	return minA.x <= maxB.x && maxA.x >= minB.x && minA.y <= maxB.y && maxA.y >= minB.y && minA.z <= maxB.z && maxA.z >= minB.z;
+}
+
+/// <summary>
+/// True if part of the box [min, max] lies below the plane's surface plus margin
+/// </summary>
+static inline bool ReachesPlane(const PlaneCollider& plane, glm::vec3 min, glm::vec3 max, float margin)
+{
+	const glm::vec3 center = (min + max) * 0.5f, halfExtents = (max - min) * 0.5f;
+	return glm::dot(plane.normal, center) - glm::dot(glm::abs(plane.normal), halfExtents) < plane.offset + margin;
+}
+
+template <typename Collider>
+static void CollectNear(const std::vector<Collider>& colliders, std::vector<Collider>& nearColliders, glm::vec3 min, glm::vec3 max)
+{
+	for (size_t i = 0; i < colliders.size(); i++)
+	{
+		glm::vec3 colliderMin, colliderMax;
+		GetColliderBounds(colliders[i], colliderMin, colliderMax);
+		if (Overlaps(colliderMin, colliderMax, min, max))
+			nearColliders.push_back(colliders[i]);
+	}
+}
+
+/// <summary>
+/// Move particle i out of a collider to resolved. Inelastic contact: the particle keeps the tangential part of its
+/// Verlet velocity and loses the part into the surface; moving the position alone would turn the push into an outward velocity
+/// </summary>
+static inline void ResolveContact(ClothParticles& particles, size_t i, glm::vec3 resolved, glm::vec3 direction)
+{
+	const glm::vec3 velocity = particles.GetPosition(i) - particles.GetPrevPosition(i);
+	const float normalVelocity = std::min(glm::dot(velocity, direction), 0.0f);
+
+	particles.SetPosition(i, resolved);
+	particles.SetPrevPosition(i, resolved - (velocity - direction * normalVelocity));
+}
+
+/// <summary>
+/// Sphere tracing: march along start + step * s, each time by the distance to the collider, until the particle comes within
+/// margin of it. A hit before t moves t there and gives the resolved position, margin away from the surface, and the normal
+/// </summary>
+template <typename Distance>
+static void SweepDistance(const Distance& distanceTo, glm::vec3 start, glm::vec3 step, float margin, float& t, glm::vec3& resolved, glm::vec3& normal)
+{
+	const float length = glm::length(step);
+
+	glm::vec3 surfaceNormal;
+	float distance = distanceTo(start, surfaceNormal);
+
+	// Starting within the margin is left to the discrete tests
+	if (distance <= margin)
+		return;
+
+	float s = 0.0f;
+	for (int iteration = 0; iteration < SWEEP_ITERATIONS; iteration++)
+	{
+		const float next = s + (distance - margin) / length;
+		if (next >= t)
+			return;
+
+		glm::vec3 nextNormal;
+		const float nextDistance = distanceTo(start + step * next, nextNormal);
+
+		s = next;
+		distance = nextDistance;
+		surfaceNormal = nextNormal;
+
+		if (distance - margin <= SWEEP_TOLERANCE)
+			break;
+	}
+
+	// Out of iterations while grazing the surface: only a hit if the particle ended up inside the margin
+	glm::vec3 endNormal;
+	if (distance - margin > SWEEP_TOLERANCE && distanceTo(start + step * t, endNormal) > margin)
+		return;
+
+	t = s;
+	resolved = start + step * s;
+	normal = surfaceNormal;
+}
+
+/// <summary>
+/// Wake the tiles around the old and new place of every collider of one kind that changed since the last frame
+/// </summary>
+template <typename Collider>
+static void WakeChangedColliders(ClothSolver& solver, const std::vector<Collider>& colliders, const std::vector<Collider>& lastColliders,
+	const glm::mat4& worldToCloth, float margin)
+{
+	for (size_t i = 0; i < std::max(colliders.size(), lastColliders.size()); i++)
+	{
+		if (i < colliders.size() && i < lastColliders.size() && colliders[i] == lastColliders[i])
+			continue;
+
+		for (int version = 0; version < 2; version++)
+		{
+			const std::vector<Collider>& list = version == 0 ? colliders : lastColliders;
+			if (i >= list.size())
+				continue;
+
+			glm::vec3 min, max;
+			if (!GetColliderBounds(list[i], min, max))
+			{
+				solver.WakeAll();
+				return;
+			}
+
+			TransformBounds(worldToCloth, min, max);
+			solver.WakeRegion(min - margin, max + margin);
+		}
+	}
+}
+
+static inline bool SameForceField(const ForceField& a, const ForceField& b)
+{
+	return a.type == b.type && a.acceleration == b.acceleration && a.amount == b.amount;
+}
+
+/// <summary>
+/// Raise value to at least candidate. Max is order independent, so the result doesn't depend on thread timing
+/// </summary>
+static inline void AtomicMax(std::atomic<float>& value, float candidate)
+{
+	float current = value.load(std::memory_order_relaxed);
+	while (candidate > current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+		;
+}
+
+/// <summary>
+/// Copy the links of a coloured table that have a particle able to move. Links between two particles that can't move
+/// do nothing, and would divide by a zero total inverse mass
+/// </summary>
+static void FilterActiveConstraints(const ClothParticles& particles, const std::vector<DistanceConstraint>& constraints, const std::vector<size_t>& batches,
+	std::vector<DistanceConstraint>& activeConstraints, std::vector<size_t>& activeBatches)
+{
+	activeConstraints.clear();
+	activeBatches.assign(1, 0);
+	for (size_t batch = 0; batch + 1 < batches.size(); batch++)
+	{
+		for (size_t c = batches[batch]; c < batches[batch + 1]; c++)
+			if (particles.invMass[constraints[c].i] + particles.invMass[constraints[c].j] > 0.0f)
+				activeConstraints.push_back(constraints[c]);
+
+		activeBatches.push_back(activeConstraints.size());
+	}
+}
+
+ClothSolver::ClothSolver(float width, float depth, unsigned int wP, unsigned int dP, unsigned int gridRes, float initHeight,
+	const ClothSolverSettings& settings, ThreadPool& pool)
+	:
+	width(width), depth(depth), gridRes(gridRes), settings(settings), m_pool(pool), m_integrate(SelectIntegrationKernel()), m_windSeed(0),
+	m_residual(0.0f), m_colliderKernels(SelectColliderKernels()), m_sleepingTiles(0), m_awakeParticles(0), m_substepScale(1.0f), m_jacobi(SelectJacobiKernel()), m_lastModelMatrix(1.0f), m_lastGravity(settings.gravity),
+	m_lastSlack(settings.slack), m_lastSolverMode(settings.solverMode), m_lastCompliance(settings.compliance)
+{
+	// Calculate the steps for each quad
+	widthStep = width / wP;
+	depthStep = depth / dP;
+
+	// Calculate the steps for texCoords
+	/*dU = 0.9f / wP;
+	dV = 0.9f / wP;*/
+	dU = 1.0f / (gridRes - 1);
+	dV = 1.0f / (gridRes - 1);
+
+	// Calculate vertices
+	particles.Resize(gridRes * gridRes);
+	unsigned int dI = 0;
+	for (float d = 0.0f; dI < gridRes; d += depthStep, dI++)
+	{
+		float v = dI * dV;
+		unsigned int wI = 0;
+		for (float w = 0.0f; wI < gridRes; w += widthStep, wI++)
+		{
+			glm::vec3 tempVertex;
+
+			tempVertex.y = initHeight;
+
+			tempVertex.x = w;
+			tempVertex.z = d;
+
+			//vertices.push_back(tempVertex);
+
+			float u = wI * dU;
+
+			texCoords.push_back(glm::vec2(u, v));
+
+			// Top row is pinned
+			const size_t particle = wI + dI * gridRes;
+			particles.SetPosition(particle, tempVertex);
+			particles.invMass[particle] = dI == 0 ? 0.0f : 1.0f;
+		}
+	}
+
+	// Calculate indices
+	unsigned int indexStart = 0;
+	for (size_t i = 0; i < (gridRes - 1) * (gridRes - 1); i++)
+	{
+		if (i != 0 && i % (gridRes - 1) == 0)
+			indexStart++;
+
+		indices.push_back(indexStart);
+		indices.push_back(indexStart + 1);
+		indices.push_back(indexStart + gridRes + 1);
+		indices.push_back(indexStart + gridRes);
+
+		indexStart++;
+	}
+
+	// Calculate triangle indices
+	for (size_t i = 0; i < indices.size(); i += 4)
+	{
+		triIndices.push_back(indices[i]);
+		triIndices.push_back(indices[i + 1]);
+		triIndices.push_back(indices[i + 2]);
+
+		triIndices.push_back(indices[i]);
+		triIndices.push_back(indices[i + 2]);
+		triIndices.push_back(indices[i + 3]);
+	}
+
+	// Store initial positions
+	particles.prevX = particles.x;
+	particles.prevY = particles.y;
+	particles.prevZ = particles.z;
+
+	// Build the distance constraint table: one entry per horizontal and vertical grid edge.
+	// Edges between two pinned particles can never move and are left out.
+	// Edges are sorted into 4 colours (horizontal/vertical, even/odd start) so no two edges of a
+	// colour share a particle, and each colour can be solved in parallel
+	std::vector<DistanceConstraint> colours[CONSTRAINT_COLOURS];
+	for (unsigned int y = 0; y < gridRes; y++)
+		for (unsigned int x = 0; x < gridRes; x++)
+		{
+			const unsigned int i = x + y * gridRes;
+
+			if (x + 1 < gridRes)
+				AddConstraint(colours[x % 2], i, i + 1);
+
+			if (y + 1 < gridRes)
+				AddConstraint(colours[2 + y % 2], i, i + gridRes);
+		}
+
+	constraintBatches.push_back(0);
+	for (int colour = 0; colour < CONSTRAINT_COLOURS; colour++)
+	{
+		constraints.insert(constraints.end(), colours[colour].begin(), colours[colour].end());
+		constraintBatches.push_back(constraints.size());
+	}
+
+	BuildTethers();
+	BuildJacobiLinks();
+	BuildMultigrid();
+	m_implicit.Build(particles, gridRes);
+
+	// Every tile starts awake
+	m_invMass.assign(particles.invMass.begin(), particles.invMass.end());
+	m_tilesX = (gridRes + SLEEP_TILE_SIZE - 1) / SLEEP_TILE_SIZE;
+	const size_t tileCount = m_tilesX * m_tilesX;
+	m_tileRestFrames.assign(tileCount, 0);
+	m_tileAsleep.assign(tileCount, 0);
+	m_tileMoving.assign(tileCount, 0);
+	m_tileMin.assign(tileCount, glm::vec3(0.0f));
+	m_tileMax.assign(tileCount, glm::vec3(0.0f));
+	UpdateActiveSets();
+
+	std::cout << "Created cloth mesh with " << particles.count << " vertices and " << triIndices.size() << " indices ("
+		<< GetIntegrationKernelName(m_integrate) << " integration)" << std::endl;
+}
+
+void ClothSolver::AddConstraint(std::vector<DistanceConstraint>& batch, unsigned int i, unsigned int j)
+{
+	if (particles.invMass[i] == 0.0f && particles.invMass[j] == 0.0f)
+		return;
+
+	DistanceConstraint constraint;
+	constraint.i = i;
+	constraint.j = j;
+	constraint.restLength = glm::length(particles.GetPosition(i) - particles.GetPosition(j));
+
+	batch.push_back(constraint);
+}
+
+void ClothSolver::ApplyForces(const std::vector<ForceField>& forceFields, float dt, float substepScale)
+{
+	Integrate(GatherForces(forceFields, dt, substepScale), "integration issue");
+}
+
+IntegrationTerms ClothSolver::GatherForces(const std::vector<ForceField>& forceFields, float dt, float substepScale)
+{
+	// Velocities are distances per substep, so a shorter substep gains less of them per step twice over
+	const float accelerationDt = dt * substepScale * substepScale;
+	const float dragDt = dt * substepScale;
+
+	// Gather every external term, then integrate once
+	IntegrationTerms terms;
+	terms.acceleration = settings.gravity * accelerationDt;
+
+	for (size_t i = 0; i < forceFields.size(); i++)
+	{
+		const ForceField& field = forceFields[i];
+
+		switch (field.type)
+		{
+		case ForceFieldType::CONSTANT:
+			terms.acceleration += field.acceleration * accelerationDt;
+			break;
+		case ForceFieldType::DRAG:
+			// The drag term (prev - current) * drag * dt folds into a scaled velocity
+			terms.damping += field.amount * dragDt;
+			break;
+		case ForceFieldType::WIND:
+			terms.wind += field.amount * accelerationDt;
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (terms.wind != 0.0f)
+		terms.windSeed = m_windSeed++;
+
+	return terms;
+}
+
+void ClothSolver::BuildTethers()
+{
+	std::vector<unsigned int> pinned;
+	for (unsigned int i = 0; i < particles.count; i++)
+		if (particles.invMass[i] == 0.0f)
+			pinned.push_back(i);
+
+	tethers.clear();
+	if (pinned.empty())
+		return;
+
+	// The cloth starts out as a flat sheet, so the shortest way across it is the straight line
+	std::vector<Tether> nearest(particles.count);
+	m_pool.ParallelFor(particles.count, MIN_PARTICLES_PER_TASK / 16, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const glm::vec3 position = particles.GetPosition(i);
+
+			Tether tether = { static_cast<unsigned int>(i), pinned[0], std::numeric_limits<float>::max() };
+			for (size_t p = 0; p < pinned.size(); p++)
+			{
+				const float distance = glm::length(particles.GetPosition(pinned[p]) - position);
+				if (distance < tether.restLength)
+				{
+					tether.anchor = pinned[p];
+					tether.restLength = distance;
+				}
+			}
+
+			nearest[i] = tether;
+		}
+	});
+
+	for (size_t i = 0; i < nearest.size(); i++)
+		if (particles.invMass[i] != 0.0f)
+			tethers.push_back(nearest[i]);
+}
+
+void ClothSolver::ApplyTethers()
+{
+	if (!settings.tethers)
+		return;
+
+	const float slack = settings.slack;
+
+	m_pool.ParallelFor(tethers.size(), MIN_CONSTRAINTS_PER_TASK, [&](size_t begin, size_t end)
+	{
+		for (size_t t = begin; t < end; t++)
+		{
+			const Tether& tether = tethers[t];
+
+			// Asleep particles stay where they are
+			if (particles.invMass[tether.particle] == 0.0f)
+				continue;
+
+			const glm::vec3 anchor = particles.GetPosition(tether.anchor);
+			const glm::vec3 offset = particles.GetPosition(tether.particle) - anchor;
+			const float distance = glm::length(offset);
+			const float maxDistance = tether.restLength * slack;
+
+			if (distance > maxDistance)
+				particles.SetPosition(tether.particle, anchor + offset * (maxDistance / distance));
+		}
+	});
+}
+
+int ClothSolver::ApplyConstraints(float dt)
+{
+	m_residual = 0.0f;
+
+	switch (settings.solverMode)
+	{
+	case ClothSolverMode::XPBD:
+		return SolveXPBD(dt);
+	case ClothSolverMode::MULTIGRID:
+		return SolveMultigrid();
+	case ClothSolverMode::JACOBI:
+		return SolveJacobi();
+	case ClothSolverMode::IMPLICIT:
+		// The springs were solved by the implicit step, only the tethers are left
+		ApplyTethers();
+		m_residual = m_implicit.GetResidual();
+		return 0;
+	case ClothSolverMode::GAUSS_SEIDEL:
+	default:
+		return SolveGaussSeidel();
+	}
+}
+
+int ClothSolver::SolveGaussSeidel()
+{
+	const float slack = settings.slack;
+
+	int iteration = 0;
+	while (iteration < settings.constraintIterations)
+	{
+		ApplyTethers();
+
+		iteration++;
+		m_residual = SweepConstraints(m_activeConstraints, m_activeBatches, slack);
+
+		// Everything was within tolerance before this sweep touched it, further sweeps won't change much
+		if (m_residual <= settings.tolerance)
+			break;
+	}
+
+	return iteration;
+}
+
+float ClothSolver::SweepConstraints(const std::vector<DistanceConstraint>& batchedConstraints, const std::vector<size_t>& batches, float slack)
+{
+	std::atomic<float> residual(0.0f);
+
+	for (size_t batch = 0; batch + 1 < batches.size(); batch++)
+	{
+		const DistanceConstraint* batchConstraints = batchedConstraints.data() + batches[batch];
+		const size_t batchSize = batches[batch + 1] - batches[batch];
+
+		m_pool.ParallelFor(batchSize, MIN_CONSTRAINTS_PER_TASK, [&](size_t begin, size_t end)
+		{
+			float chunkResidual = 0.0f;
+			for (size_t c = begin; c < end; c++)
+				chunkResidual = std::max(chunkResidual, SolveDistanceConstraint(particles, batchConstraints[c], slack));
+
+			AtomicMax(residual, chunkResidual);
+		});
+	}
+
+	return residual.load();
+}
+
+int ClothSolver::SolveXPBD(float dt)
+{
+	const float slack = settings.slack;
+	const float compliance = settings.compliance / (dt * dt);
+
+	// Multipliers build up over the sweeps of one substep
+	m_lambdas.assign(m_activeConstraints.size(), 0.0f);
+
+	int iteration = 0;
+	while (iteration < settings.constraintIterations)
+	{
+		ApplyTethers();
+
+		std::atomic<float> residual(0.0f);
+
+		for (size_t batch = 0; batch + 1 < m_activeBatches.size(); batch++)
+		{
+			const size_t batchBegin = m_activeBatches[batch];
+			const size_t batchSize = m_activeBatches[batch + 1] - batchBegin;
+
+			m_pool.ParallelFor(batchSize, MIN_CONSTRAINTS_PER_TASK, [&](size_t begin, size_t end)
+			{
+				float chunkResidual = 0.0f;
+				for (size_t c = batchBegin + begin; c < batchBegin + end; c++)
+					chunkResidual = std::max(chunkResidual, SolveCompliantConstraint(particles, m_activeConstraints[c], slack, compliance, m_lambdas[c]));
+
+				AtomicMax(residual, chunkResidual);
+			});
+		}
+
+		iteration++;
+		m_residual = residual.load();
+
+		if (m_residual <= settings.tolerance)
+			break;
+	}
+
+	return iteration;
+}
+
+int ClothSolver::SolveJacobi()
+{
+	JacobiTerms terms;
+	terms.invMass = particles.invMass.data();
+	terms.restLeft = m_restLeft.data();
+	terms.restRight = m_restRight.data();
+	terms.restUp = m_restUp.data();
+	terms.restDown = m_restDown.data();
+	terms.gridRes = gridRes;
+	terms.slack = settings.slack;
+
+	// The padding is copied along and never written
+	m_lastX = particles.x;
+	m_lastY = particles.y;
+	m_lastZ = particles.z;
+	m_nextX = particles.x;
+	m_nextY = particles.y;
+	m_nextZ = particles.z;
+
+	const float rhoSquared = settings.chebyshevRho * settings.chebyshevRho;
+	float omega = 1.0f;
+
+	int iteration = 0;
+	while (iteration < settings.constraintIterations)
+	{
+		ApplyTethers();
+
+		// Chebyshev semi-iterative weights; plain sweeps first, while the error is far from its slowest mode
+		if (rhoSquared == 0.0f || iteration < JACOBI_CHEBYSHEV_DELAY)
+			omega = 1.0f;
+		else if (iteration == JACOBI_CHEBYSHEV_DELAY)
+			omega = 2.0f / (2.0f - rhoSquared);
+		else
+			omega = 4.0f / (4.0f - rhoSquared * omega);
+
+		terms.x = particles.x.data();
+		terms.y = particles.y.data();
+		terms.z = particles.z.data();
+		terms.lastX = m_lastX.data();
+		terms.lastY = m_lastY.data();
+		terms.lastZ = m_lastZ.data();
+		terms.outX = m_nextX.data();
+		terms.outY = m_nextY.data();
+		terms.outZ = m_nextZ.data();
+		terms.omega = omega;
+
+		std::atomic<float> residual(0.0f);
+		m_pool.ParallelFor(gridRes, std::max<size_t>(1, MIN_PARTICLES_PER_TASK / gridRes), [&](size_t begin, size_t end)
+		{
+			float chunkResidual = 0.0f;
+			for (size_t row = begin; row < end; row++)
+				chunkResidual = std::max(chunkResidual, m_jacobi(terms, row));
+
+			AtomicMax(residual, chunkResidual);
+		});
+
+		// The sweep's start becomes the last positions, its result the current ones
+		std::swap(m_lastX, particles.x);
+		std::swap(m_lastY, particles.y);
+		std::swap(m_lastZ, particles.z);
+		std::swap(particles.x, m_nextX);
+		std::swap(particles.y, m_nextY);
+		std::swap(particles.z, m_nextZ);
+
+		iteration++;
+		m_residual = residual.load();
+
+		if (m_residual <= settings.tolerance)
+			break;
+	}
+
+	return iteration;
+}
+
+void ClothSolver::BuildJacobiLinks()
+{
+	m_restLeft.assign(particles.paddedCount, 0.0f);
+	m_restRight.assign(particles.paddedCount, 0.0f);
+	m_restUp.assign(particles.paddedCount, 0.0f);
+	m_restDown.assign(particles.paddedCount, 0.0f);
+
+	// Links between two pinned particles were left out of the table, and stay at 0 here
+	for (size_t c = 0; c < constraints.size(); c++)
+	{
+		const DistanceConstraint& constraint = constraints[c];
+		if (constraint.j == constraint.i + 1)
+		{
+			m_restRight[constraint.i] = constraint.restLength;
+			m_restLeft[constraint.j] = constraint.restLength;
+		}
+		else
+		{
+			m_restDown[constraint.i] = constraint.restLength;
+			m_restUp[constraint.j] = constraint.restLength;
+		}
+	}
+}
+
+int ClothSolver::SolveMultigrid()
+{
+	const float slack = settings.slack;
+
+	int iteration = 0;
+	while (iteration < settings.constraintIterations)
+	{
+		ApplyTethers();
+
+		m_cycleStart.resize(particles.count);
+		m_pool.ParallelFor(particles.count, MIN_PARTICLES_PER_TASK, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+				m_cycleStart[i] = particles.GetPosition(i);
+		});
+
+		// Coarsest first: each level starts from the correction of the ones above it
+		for (size_t level = m_levels.size(); level-- > 0;)
+		{
+			SweepConstraints(m_levels[level].activeConstraints, m_levels[level].activeBatches, slack);
+			ProlongCorrection(level);
+		}
+
+		iteration++;
+		m_residual = SweepConstraints(m_activeConstraints, m_activeBatches, slack);
+
+		if (m_residual <= settings.tolerance)
+			break;
+	}
+
+	return iteration;
+}
+
+void ClothSolver::BuildMultigrid()
+{
+	m_levels.clear();
+
+	std::vector<unsigned int> finerLines(gridRes);
+	for (unsigned int line = 0; line < gridRes; line++)
+		finerLines[line] = line;
+
+	while (finerLines.size() > MULTIGRID_COARSEST_LINES)
+	{
+		GridLevel level;
+
+		// Every other line, and the last one so the cloth's border stays on every level
+		for (size_t k = 0; k < finerLines.size(); k += 2)
+			level.lines.push_back(finerLines[k]);
+		if (level.lines.back() != finerLines.back())
+			level.lines.push_back(finerLines.back());
+
+		// Odd lines lie between the kept ones around them, in proportion to their distance on the grid
+		for (size_t k = 0; k < finerLines.size(); k++)
+		{
+			LineWeight weight = { finerLines[k], finerLines[k], finerLines[k], 0.0f };
+			if (k % 2 == 1 && k + 1 < finerLines.size())
+			{
+				weight.lower = finerLines[k - 1];
+				weight.upper = finerLines[k + 1];
+				weight.t = static_cast<float>(weight.line - weight.lower) / (weight.upper - weight.lower);
+			}
+			level.weights.push_back(weight);
+		}
+
+		// Links between neighbouring kept particles, in the fine grid's colours so every colour is independent
+		std::vector<DistanceConstraint> colours[CONSTRAINT_COLOURS];
+		const unsigned int count = static_cast<unsigned int>(level.lines.size());
+		for (unsigned int y = 0; y < count; y++)
+			for (unsigned int x = 0; x < count; x++)
+			{
+				const unsigned int i = level.lines[x] + level.lines[y] * gridRes;
+
+				if (x + 1 < count)
+					AddConstraint(colours[x % 2], i, level.lines[x + 1] + level.lines[y] * gridRes);
+
+				if (y + 1 < count)
+					AddConstraint(colours[2 + y % 2], i, level.lines[x] + level.lines[y + 1] * gridRes);
+			}
+
+		level.batches.push_back(0);
+		for (int colour = 0; colour < CONSTRAINT_COLOURS; colour++)
+		{
+			level.constraints.insert(level.constraints.end(), colours[colour].begin(), colours[colour].end());
+			level.batches.push_back(level.constraints.size());
+		}
+
+		finerLines = level.lines;
+		m_levels.push_back(level);
+	}
+}
+
+void ClothSolver::ProlongCorrection(size_t level)
+{
+	const std::vector<LineWeight>& weights = m_levels[level].weights;
+
+	// Every finer particle is written by its own row and only reads particles of the coarse level, so rows are independent
+	m_pool.ParallelFor(weights.size(), std::max<size_t>(1, MIN_PARTICLES_PER_TASK / weights.size()), [&](size_t begin, size_t end)
+	{
+		for (size_t row = begin; row < end; row++)
+		{
+			const LineWeight& wy = weights[row];
+
+			for (size_t column = 0; column < weights.size(); column++)
+			{
+				const LineWeight& wx = weights[column];
+
+				// Particles on the coarse level already moved
+				if (wx.lower == wx.upper && wy.lower == wy.upper)
+					continue;
+
+				// Asleep and pinned ones stay put
+				const size_t i = wx.line + wy.line * gridRes;
+				if (particles.invMass[i] == 0.0f)
+					continue;
+
+				const size_t i00 = wx.lower + wy.lower * gridRes, i10 = wx.upper + wy.lower * gridRes;
+				const size_t i01 = wx.lower + wy.upper * gridRes, i11 = wx.upper + wy.upper * gridRes;
+
+				const glm::vec3 lower = glm::mix(particles.GetPosition(i00) - m_cycleStart[i00], particles.GetPosition(i10) - m_cycleStart[i10], wx.t);
+				const glm::vec3 upper = glm::mix(particles.GetPosition(i01) - m_cycleStart[i01], particles.GetPosition(i11) - m_cycleStart[i11], wx.t);
+
+				particles.SetPosition(i, particles.GetPosition(i) + glm::mix(lower, upper, wy.t));
+			}
+		}
+	});
+}
+
+float ClothSolver::GetSubstepScale() const
+{
+	if (settings.solverMode == ClothSolverMode::XPBD || settings.solverMode == ClothSolverMode::IMPLICIT)
+		return static_cast<float>(XPBD_REFERENCE_SUBSTEPS) / std::max(settings.substeps, 1);
+
+	return 1.0f;
+}
+
+void ClothSolver::RescaleVelocities(float scale)
+{
+	const float ratio = scale / m_substepScale;
+	for (size_t i = 0; i < particles.count; i++)
+	{
+		const glm::vec3 position = particles.GetPosition(i);
+		particles.SetPrevPosition(i, position - (position - particles.GetPrevPosition(i)) * ratio);
+	}
+
+	m_substepScale = scale;
+}
+
+void ClothSolver::Integrate(const IntegrationTerms& terms, const char* issue)
+{
+	std::atomic<bool> finite(true);
+
+	// Only awake particles are swept. Each range holds at most MIN_PARTICLES_PER_TASK particles,
+	// so hand out enough ranges per task to make waking a thread worth it
+	const size_t minRanges = std::max<size_t>(1, m_awakeRanges.size() * MIN_PARTICLES_PER_TASK / std::max<size_t>(m_awakeParticles, 1));
+
+	m_pool.ParallelFor(m_awakeRanges.size(), minRanges, [&](size_t begin, size_t end)
+	{
+		for (size_t r = begin; r < end; r++)
+			if (!m_integrate(particles, m_awakeRanges[r].begin, m_awakeRanges[r].end, terms))
+				finite = false;
+	});
+
+	if (!finite)
+	{
+		throw std::runtime_error(issue);
+	}
+}
+
+void ClothSolver::Collide(const ColliderSet& colliders, const glm::mat4& modelMatrix)
+{
+	if (colliders.IsEmpty())
+		return;
+
+	glm::vec3 clothMin(std::numeric_limits<float>::max()), clothMax(-std::numeric_limits<float>::max());
+	float maxStep = 0.0f;
+	for (size_t i = 0; i < particles.count; i++)
+	{
+		const glm::vec3 position = particles.GetPosition(i);
+		clothMin = glm::min(clothMin, position);
+		clothMax = glm::max(clothMax, position);
+		maxStep = std::max(maxStep, glm::length(position - particles.GetPrevPosition(i)));
+	}
+
+	// Where the particles started the substep is at most maxStep further out
+	glm::vec3 worldMin = clothMin - maxStep, worldMax = clothMax + maxStep;
+	TransformBounds(modelMatrix, worldMin, worldMax);
+
+	GatherNearColliders(colliders, worldMin, worldMax);
+
+	if (settings.continuousCollision)
+		m_stats.sweptContacts += SweepColliders(modelMatrix);
+
+	CollidePrimitives(modelMatrix);
+	CollideMeshes(colliders.meshes, modelMatrix, clothMin, clothMax, maxStep);
+}
+
+void ClothSolver::GatherNearColliders(const ColliderSet& colliders, glm::vec3 worldMin, glm::vec3 worldMax)
+{
+	const float margin = settings.colliderMargin;
+
+	m_nearColliders.Clear();
+	m_nearSDFs.clear();
+	m_nearMeshes.clear();
+
+	CollectNear(colliders.spheres, m_nearColliders.spheres, worldMin - margin, worldMax + margin);
+	CollectNear(colliders.capsules, m_nearColliders.capsules, worldMin - margin, worldMax + margin);
+	CollectNear(colliders.boxes, m_nearColliders.boxes, worldMin - margin, worldMax + margin);
+
+	for (size_t i = 0; i < colliders.planes.size(); i++)
+		if (ReachesPlane(colliders.planes[i], worldMin, worldMax, margin))
+			m_nearColliders.planes.push_back(colliders.planes[i]);
+
+	for (size_t i = 0; i < colliders.sdfs.size(); i++)
+	{
+		const SDFCollider& sdf = colliders.sdfs[i];
+		if (sdf.grid == nullptr || sdf.grid->IsEmpty())
+			continue;
+
+		NearSDF nearSDF;
+		GetColliderBounds(sdf, nearSDF.min, nearSDF.max);
+		if (!Overlaps(nearSDF.min, nearSDF.max, worldMin - margin, worldMax + margin))
+			continue;
+
+		nearSDF.grid = sdf.grid;
+		nearSDF.gridToWorld = sdf.modelMatrix;
+		nearSDF.worldToGrid = glm::inverse(sdf.modelMatrix);
+		nearSDF.scale = glm::length(glm::vec3(sdf.modelMatrix[0]));
+		m_nearSDFs.push_back(nearSDF);
+	}
+
+	for (size_t i = 0; i < colliders.meshes.size(); i++)
+	{
+		const MeshCollider& mesh = colliders.meshes[i];
+		if (mesh.bvh == nullptr || mesh.bvh->IsEmpty())
+			continue;
+
+		NearMesh nearMesh;
+		GetColliderBounds(mesh, nearMesh.min, nearMesh.max);
+		if (!Overlaps(nearMesh.min, nearMesh.max, worldMin - margin, worldMax + margin))
+			continue;
+
+		nearMesh.bvh = mesh.bvh;
+		nearMesh.worldToMesh = glm::inverse(mesh.modelMatrix);
+		nearMesh.normalToWorld = glm::transpose(glm::mat3(nearMesh.worldToMesh));
+		m_nearMeshes.push_back(nearMesh);
+	}
+}
+
+int ClothSolver::SweepColliders(const glm::mat4& modelMatrix)
+{
+	const float margin = settings.colliderMargin;
+	const ColliderSet& nearby = m_nearColliders;
+	if (nearby.IsEmpty() && m_nearSDFs.empty() && m_nearMeshes.empty())
+		return 0;
+
+	const glm::mat4 worldToCloth = glm::inverse(modelMatrix);
+	const glm::mat3 normalToCloth = glm::transpose(glm::mat3(modelMatrix));
+	std::atomic<int> contacts(0);
+
+	m_pool.ParallelFor(particles.count, MIN_COLLISION_PARTICLES_PER_TASK, [&](size_t begin, size_t end)
+	{
+		int taskContacts = 0;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			if (particles.invMass[i] == 0.0f)
+				continue;
+
+			const glm::vec3 start = glm::vec3(modelMatrix * glm::vec4(particles.GetPrevPosition(i), 1.0f));
+			const glm::vec3 step = glm::vec3(modelMatrix * glm::vec4(particles.GetPosition(i), 1.0f)) - start;
+
+			// Slower particles can't get through the margin in one substep, the discrete tests keep them out
+			if (glm::dot(step, step) <= margin * margin)
+				continue;
+
+			const glm::vec3 reachMin = glm::min(start, start + step) - margin, reachMax = glm::max(start, start + step) + margin;
+			float t = 1.0f;
+			glm::vec3 resolved(0.0f), normal(0.0f), colliderMin, colliderMax;
+
+			for (size_t c = 0; c < nearby.spheres.size(); c++)
+			{
+				const SphereCollider& sphere = nearby.spheres[c];
+				GetColliderBounds(sphere, colliderMin, colliderMax);
+				if (Overlaps(colliderMin, colliderMax, reachMin, reachMax))
+					SweepDistance([&](glm::vec3 p, glm::vec3& n) { return GetColliderDistance(sphere, p, n); }, start, step, margin, t, resolved, normal);
+			}
+
+			for (size_t c = 0; c < nearby.capsules.size(); c++)
+			{
+				const CapsuleCollider& capsule = nearby.capsules[c];
+				GetColliderBounds(capsule, colliderMin, colliderMax);
+				if (Overlaps(colliderMin, colliderMax, reachMin, reachMax))
+					SweepDistance([&](glm::vec3 p, glm::vec3& n) { return GetColliderDistance(capsule, p, n); }, start, step, margin, t, resolved, normal);
+			}
+
+			for (size_t c = 0; c < nearby.boxes.size(); c++)
+			{
+				const BoxCollider& box = nearby.boxes[c];
+				GetColliderBounds(box, colliderMin, colliderMax);
+				if (Overlaps(colliderMin, colliderMax, reachMin, reachMax))
+					SweepDistance([&](glm::vec3 p, glm::vec3& n) { return GetColliderDistance(box, p, n); }, start, step, margin, t, resolved, normal);
+			}
+
+			for (size_t c = 0; c < nearby.planes.size(); c++)
+			{
+				const PlaneCollider& plane = nearby.planes[c];
+				if (ReachesPlane(plane, reachMin, reachMax, 0.0f))
+					SweepDistance([&](glm::vec3 p, glm::vec3& n) { return GetColliderDistance(plane, p, n); }, start, step, margin, t, resolved, normal);
+			}
+
+			for (size_t c = 0; c < m_nearSDFs.size(); c++)
+			{
+				const NearSDF& sdf = m_nearSDFs[c];
+				if (Overlaps(sdf.min, sdf.max, reachMin, reachMax))
+					SweepDistance([&](glm::vec3 p, glm::vec3& n) { return GetSDFDistance(*sdf.grid, sdf.worldToGrid, sdf.gridToWorld, sdf.scale, p, n); },
+						start, step, margin, t, resolved, normal);
+			}
+
+			// Vertex-triangle: the segment against the front faces of the meshes
+			for (size_t c = 0; c < m_nearMeshes.size(); c++)
+			{
+				const NearMesh& mesh = m_nearMeshes[c];
+				if (!Overlaps(mesh.min, mesh.max, reachMin, reachMax))
+					continue;
+
+				const glm::vec3 meshStart = glm::vec3(mesh.worldToMesh * glm::vec4(start, 1.0f));
+				const glm::vec3 meshStep = glm::mat3(mesh.worldToMesh) * step;
+
+				float hit;
+				glm::vec3 faceNormal;
+				if (!mesh.bvh->Raycast(meshStart, meshStep, t, hit, faceNormal, true))
+					continue;
+
+				const glm::vec3 worldNormal = glm::normalize(mesh.normalToWorld * faceNormal);
+				t = hit;
+				resolved = start + step * hit + worldNormal * margin;
+				normal = worldNormal;
+			}
+
+			if (t >= 1.0f)
+				continue;
+
+			const glm::vec3 direction = normalToCloth * normal;
+			const float length = glm::length(direction);
+			if (length == 0.0f)
+				continue;
+
+			ResolveContact(particles, i, glm::vec3(worldToCloth * glm::vec4(resolved, 1.0f)), direction / length);
+			taskContacts++;
+		}
+
+		contacts += taskContacts;
+	});
+
+	return contacts.load();
+}
+
+void ClothSolver::CollidePrimitives(const glm::mat4& modelMatrix)
+{
+	const float margin = settings.colliderMargin;
+
+	const ColliderSet& nearby = m_nearColliders;
+	if (nearby.spheres.empty() && nearby.capsules.empty() && nearby.boxes.empty() && nearby.planes.empty() && m_nearSDFs.empty())
+		return;
+
+	// Pushes are found in world space and applied in cloth space
+	const glm::mat3 worldToCloth = glm::inverse(glm::mat3(modelMatrix));
+	const ColliderKernels& kernels = m_colliderKernels;
+
+	m_pool.ParallelFor(particles.count, MIN_COLLISION_PARTICLES_PER_TASK, [&](size_t begin, size_t end)
+	{
+		ColliderBlock block, start;
+
+		for (size_t first = begin; first < end; first += COLLIDER_BLOCK_SIZE)
+		{
+			const size_t count = std::min<size_t>(COLLIDER_BLOCK_SIZE, end - first);
+
+			glm::vec3 blockMin(std::numeric_limits<float>::max()), blockMax(-std::numeric_limits<float>::max());
+			for (size_t k = 0; k < count; k++)
+			{
+				const glm::vec3 world = glm::vec3(modelMatrix * glm::vec4(particles.GetPosition(first + k), 1.0f));
+				block.x[k] = world.x;
+				block.y[k] = world.y;
+				block.z[k] = world.z;
+				blockMin = glm::min(blockMin, world);
+				blockMax = glm::max(blockMax, world);
+			}
+
+			block.count = (count + 7) & ~static_cast<size_t>(7);
+			for (size_t k = count; k < block.count; k++)
+			{
+				block.x[k] = block.x[count - 1];
+				block.y[k] = block.y[count - 1];
+				block.z[k] = block.z[count - 1];
+			}
+			start = block;
+
+			// Narrow phase: only the colliders near this block run their kernel over it
+			const glm::vec3 reachMin = blockMin - margin, reachMax = blockMax + margin;
+			bool tested = false;
+			glm::vec3 colliderMin, colliderMax;
+
+			for (size_t c = 0; c < nearby.spheres.size(); c++)
+			{
+				GetColliderBounds(nearby.spheres[c], colliderMin, colliderMax);
+				if (Overlaps(colliderMin, colliderMax, reachMin, reachMax))
+				{
+					kernels.sphere(block, nearby.spheres[c], margin);
+					tested = true;
+				}
+			}
+
+			for (size_t c = 0; c < nearby.capsules.size(); c++)
+			{
+				GetColliderBounds(nearby.capsules[c], colliderMin, colliderMax);
+				if (Overlaps(colliderMin, colliderMax, reachMin, reachMax))
+				{
+					kernels.capsule(block, nearby.capsules[c], margin);
+					tested = true;
+				}
+			}
+
+			for (size_t c = 0; c < nearby.boxes.size(); c++)
+			{
+				GetColliderBounds(nearby.boxes[c], colliderMin, colliderMax);
+				if (Overlaps(colliderMin, colliderMax, reachMin, reachMax))
+				{
+					kernels.box(block, nearby.boxes[c], margin);
+					tested = true;
+				}
+			}
+
+			for (size_t c = 0; c < nearby.planes.size(); c++)
+			{
+				if (ReachesPlane(nearby.planes[c], blockMin, blockMax, margin))
+				{
+					kernels.plane(block, nearby.planes[c], margin);
+					tested = true;
+				}
+			}
+
+			for (size_t c = 0; c < m_nearSDFs.size(); c++)
+			{
+				const NearSDF& sdf = m_nearSDFs[c];
+				if (Overlaps(sdf.min, sdf.max, reachMin, reachMax))
+				{
+					CollideSDF(block, *sdf.grid, sdf.worldToGrid, sdf.gridToWorld, sdf.scale, margin);
+					tested = true;
+				}
+			}
+
+			if (!tested)
+				continue;
+
+			// Kernels leave untouched points bit for bit alone
+			for (size_t k = 0; k < count; k++)
+			{
+				const size_t i = first + k;
+				const glm::vec3 push(block.x[k] - start.x[k], block.y[k] - start.y[k], block.z[k] - start.z[k]);
+				if (particles.invMass[i] == 0.0f || push == glm::vec3(0.0f))
+					continue;
+
+				const glm::vec3 delta = worldToCloth * push;
+				ResolveContact(particles, i, particles.GetPosition(i) + delta, glm::normalize(delta));
+			}
+		}
+	});
+}
+
+void ClothSolver::CollideMeshes(const std::vector<MeshCollider>& meshes, const glm::mat4& modelMatrix, glm::vec3 clothMin, glm::vec3 clothMax,
+	float maxStep)
+{
+	const float margin = settings.colliderMargin;
+
+	for (size_t c = 0; c < meshes.size(); c++)
+	{
+		const TriangleBVH* bvh = meshes[c].bvh;
+		if (bvh == nullptr || bvh->IsEmpty())
+			continue;
+
+		// Queries run in mesh space, responses in cloth space
+		const glm::mat4 clothToMesh = glm::inverse(meshes[c].modelMatrix) * modelMatrix;
+		const glm::mat4 meshToCloth = glm::inverse(clothToMesh);
+		const glm::mat3 normalToCloth = glm::transpose(glm::mat3(clothToMesh));
+
+		// The margin can stretch by at most the largest scale of the transform
+		const glm::mat3 linear(clothToMesh);
+		const float scale = std::max(glm::length(linear[0]), std::max(glm::length(linear[1]), glm::length(linear[2])));
+
+		// Skip meshes nowhere near the cloth
+		glm::vec3 meshMin, meshMax, boundsMin = clothMin, boundsMax = clothMax;
+		bvh->GetBounds(meshMin, meshMax);
+		TransformBounds(clothToMesh, boundsMin, boundsMax);
+		const float boundsRadius = (margin + maxStep) * scale;
+		if (glm::any(glm::lessThan(boundsMax + boundsRadius, meshMin)) || glm::any(glm::greaterThan(boundsMin - boundsRadius, meshMax)))
+			continue;
+
+		m_pool.ParallelFor(particles.count, MIN_COLLISION_PARTICLES_PER_TASK, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				if (particles.invMass[i] == 0.0f)
+					continue;
+
+				const glm::vec3 position = particles.GetPosition(i);
+				const glm::vec3 meshPosition = glm::vec3(clothToMesh * glm::vec4(position, 1.0f));
+
+				// A particle that crossed the surface during this substep is at most as deep as it moved
+				const float searchRadius = (margin + glm::length(position - particles.GetPrevPosition(i))) * scale;
+
+				glm::vec3 closest, normal;
+				if (!bvh->ClosestPoint(meshPosition, searchRadius, closest, normal))
+					continue;
+
+				const glm::vec3 surface = glm::vec3(meshToCloth * glm::vec4(closest, 1.0f));
+				const glm::vec3 offset = position - surface;
+				const float distance = glm::length(offset);
+				const bool behind = glm::dot(meshPosition - closest, normal) < 0.0f;
+
+				if (!behind && distance >= margin)
+					continue;
+
+				// Outside: keep the direction to the surface. Behind it or on it: leave along its normal
+				glm::vec3 direction;
+				if (!behind && distance > 0.0f)
+					direction = offset / distance;
+				else
+				{
+					direction = normalToCloth * normal;
+					const float length = glm::length(direction);
+					if (length == 0.0f)
+						continue;
+					direction /= length;
+				}
+
+				ResolveContact(particles, i, surface + direction * margin, direction);
+			}
+		});
+	}
+}
+
+void ClothSolver::Simulate(const std::vector<ForceField>& forceFields, const ColliderSet& colliders, glm::mat4 modelMatrix, float dt)
+{
+	BeginFrame(forceFields, colliders, modelMatrix);
+
+	for (int step = 0; step < settings.substeps; step++)
+		Substep(forceFields, colliders, modelMatrix, dt);
+
+	EndFrame();
+}
+
+void ClothSolver::BeginFrame(const std::vector<ForceField>& forceFields, const ColliderSet& colliders, const glm::mat4& modelMatrix)
+{
+	WakeOnChanges(forceFields, colliders, modelMatrix);
+
+	m_stats = ClothSolverStats();
+}
+
+void ClothSolver::Substep(const std::vector<ForceField>& forceFields, const ColliderSet& colliders, const glm::mat4& modelMatrix, float dt)
+{
+	const float substepScale = GetSubstepScale();
+	if (substepScale != m_substepScale)
+		RescaleVelocities(substepScale);
+
+	// The implicit step covers the forces and the springs, its unit of time is the step the forces are tuned for
+	if (settings.solverMode == ClothSolverMode::IMPLICIT)
+		m_stats.iterations += m_implicit.Step(particles, GatherForces(forceFields, dt, 1.0f), substepScale, settings, m_pool);
+	else
+		ApplyForces(forceFields, dt, substepScale);
+
+	Collide(colliders, modelMatrix);
+
+	m_stats.iterations += ApplyConstraints(dt / std::max(settings.substeps, 1));
+	m_stats.maxIterations += settings.constraintIterations;
+	m_stats.residual = m_residual;
+
+	if (settings.selfCollision)
+		m_stats.selfContacts += static_cast<int>(m_selfCollision.Solve(particles, gridRes, settings.thickness, m_pool));
+}
+
+void ClothSolver::EndFrame()
+{
+	UpdateSleep();
+
+	m_stats.sleepingTiles = static_cast<int>(m_sleepingTiles);
+	m_stats.tiles = static_cast<int>(m_tileAsleep.size());
+}
+
+void ClothSolver::WakeAll()
+{
+	if (m_sleepingTiles == 0)
+		return;
+
+	for (size_t tile = 0; tile < m_tileAsleep.size(); tile++)
+		if (m_tileAsleep[tile])
+			WakeTile(tile);
+
+	UpdateActiveSets();
+}
+
+void ClothSolver::WakeRegion(glm::vec3 min, glm::vec3 max)
+{
+	bool changed = false;
+
+	for (size_t tile = 0; tile < m_tileAsleep.size(); tile++)
+	{
+		if (!m_tileAsleep[tile])
+			continue;
+
+		const bool overlaps = m_tileMin[tile].x <= max.x && m_tileMax[tile].x >= min.x
+			&& m_tileMin[tile].y <= max.y && m_tileMax[tile].y >= min.y
+			&& m_tileMin[tile].z <= max.z && m_tileMax[tile].z >= min.z;
+
+		if (overlaps)
+		{
+			WakeTile(tile);
+			changed = true;
+		}
+	}
+
+	if (changed)
+		UpdateActiveSets();
+}
+
+void ClothSolver::ComputeNormals(const std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals) const
+{
+	const int res = static_cast<int>(gridRes);
+	normals.resize(positions.size());
+
+	// Quad (x, y) is split along its diagonal into (a, b, c) and (a, c, d), a at (x, y), b at (x + 1, y), c at (x + 1, y + 1).
+	// Twice the area times the normal of each half, on the side its triIndices winding faces
+	auto firstHalf = [&](int x, int y)
+	{
+		const glm::vec3 a = positions[x + y * res];
+		return glm::cross(positions[x + 1 + y * res] - a, positions[x + 1 + (y + 1) * res] - a);
+	};
+	auto secondHalf = [&](int x, int y)
+	{
+		const glm::vec3 a = positions[x + y * res];
+		return glm::cross(positions[x + 1 + (y + 1) * res] - a, positions[x + (y + 1) * res] - a);
+	};
+
+	m_pool.ParallelFor(gridRes, std::max<size_t>(MIN_PARTICLES_PER_TASK / std::max(gridRes, 1u), 1), [&](size_t begin, size_t end)
+	{
+		for (int y = static_cast<int>(begin); y < static_cast<int>(end); y++)
+			for (int x = 0; x < res; x++)
+			{
+				// The vertex is a of quad (x, y), b of (x - 1, y), c of (x - 1, y - 1) and d of (x, y - 1)
+				glm::vec3 normal(0.0f);
+				if (x + 1 < res && y + 1 < res)
+					normal += firstHalf(x, y) + secondHalf(x, y);
+				if (x > 0 && y + 1 < res)
+					normal += firstHalf(x - 1, y);
+				if (x > 0 && y > 0)
+					normal += firstHalf(x - 1, y - 1) + secondHalf(x - 1, y - 1);
+				if (x + 1 < res && y > 0)
+					normal += secondHalf(x, y - 1);
+
+				const float length = glm::length(normal);
+				normals[x + y * res] = length > 0.0f ? normal / length : glm::vec3(0.0f, -1.0f, 0.0f);
+			}
+	});
+}
+
+void ClothSolver::WakeOnChanges(const std::vector<ForceField>& forceFields, const ColliderSet& colliders, const glm::mat4& modelMatrix)
+{
+	bool changed = !settings.sleeping || modelMatrix != m_lastModelMatrix || settings.gravity != m_lastGravity
+		|| settings.slack != m_lastSlack || settings.solverMode != m_lastSolverMode || settings.compliance != m_lastCompliance
+		|| forceFields.size() != m_lastForceFields.size();
+
+	for (size_t i = 0; i < forceFields.size() && !changed; i++)
+	{
+		// Gusts point somewhere new every step
+		if (forceFields[i].type == ForceFieldType::WIND && forceFields[i].amount != 0.0f)
+			changed = true;
+		else if (!SameForceField(forceFields[i], m_lastForceFields[i]))
+			changed = true;
+	}
+
+	if (changed)
+		WakeAll();
+
+	// Colliders that appeared, moved or went away wake the tiles around where they were and are now
+	if (m_sleepingTiles > 0)
+	{
+		const glm::mat4 worldToCloth = glm::inverse(modelMatrix);
+		const float margin = settings.colliderMargin;
+
+		WakeChangedColliders(*this, colliders.spheres, m_lastColliders.spheres, worldToCloth, margin);
+		WakeChangedColliders(*this, colliders.capsules, m_lastColliders.capsules, worldToCloth, margin);
+		WakeChangedColliders(*this, colliders.boxes, m_lastColliders.boxes, worldToCloth, margin);
+		WakeChangedColliders(*this, colliders.planes, m_lastColliders.planes, worldToCloth, margin);
+		WakeChangedColliders(*this, colliders.sdfs, m_lastColliders.sdfs, worldToCloth, margin);
+		WakeChangedColliders(*this, colliders.meshes, m_lastColliders.meshes, worldToCloth, margin);
+	}
+
+	m_lastColliders = colliders;
+	m_lastForceFields = forceFields;
+	m_lastModelMatrix = modelMatrix;
+	m_lastGravity = settings.gravity;
+	m_lastSlack = settings.slack;
+	m_lastSolverMode = settings.solverMode;
+	m_lastCompliance = settings.compliance;
+}
+
+void ClothSolver::UpdateSleep()
+{
+	if (!settings.sleeping)
+		return;
+
+	const float threshold = settings.sleepThreshold * settings.sleepThreshold;
+	const size_t tileCount = m_tileAsleep.size();
+
+	// Measure how far the particles of each awake tile moved during the last substep
+	m_pool.ParallelFor(tileCount, MIN_PARTICLES_PER_TASK / (SLEEP_TILE_SIZE * SLEEP_TILE_SIZE), [&](size_t begin, size_t end)
+	{
+		for (size_t tile = begin; tile < end; tile++)
+		{
+			m_tileMoving[tile] = 0;
+			if (m_tileAsleep[tile])
+				continue;
+
+			unsigned int x0, x1, y0, y1;
+			GetTileRect(tile, m_tilesX, gridRes, x0, x1, y0, y1);
+
+			float motion = 0.0f;
+			glm::vec3 tileMin(std::numeric_limits<float>::max()), tileMax(-std::numeric_limits<float>::max());
+			for (unsigned int y = y0; y < y1; y++)
+				for (unsigned int x = x0; x < x1; x++)
+				{
+					const size_t i = x + y * gridRes;
+					const glm::vec3 position = particles.GetPosition(i);
+					const glm::vec3 velocity = position - particles.GetPrevPosition(i);
+
+					motion = std::max(motion, glm::dot(velocity, velocity));
+					tileMin = glm::min(tileMin, position);
+					tileMax = glm::max(tileMax, position);
+				}
+
+			m_tileMin[tile] = tileMin;
+			m_tileMax[tile] = tileMax;
+			m_tileMoving[tile] = !(motion <= threshold);
+			m_tileRestFrames[tile] = m_tileMoving[tile] ? 0 : m_tileRestFrames[tile] + 1;
+		}
+	});
+
+	auto neighbourMoving = [&](size_t tile)
+	{
+		const size_t tx = tile % m_tilesX, ty = tile / m_tilesX;
+		return (tx > 0 && m_tileMoving[tile - 1]) || (tx + 1 < m_tilesX && m_tileMoving[tile + 1])
+			|| (ty > 0 && m_tileMoving[tile - m_tilesX]) || (ty + 1 < m_tilesX && m_tileMoving[tile + m_tilesX]);
+	};
+
+	bool changed = false;
+	for (size_t tile = 0; tile < tileCount; tile++)
+	{
+		if (m_tileAsleep[tile])
+		{
+			// Pulled on by a moving neighbour
+			if (neighbourMoving(tile))
+			{
+				WakeTile(tile);
+				changed = true;
+			}
+		}
+		else if (m_tileRestFrames[tile] >= settings.sleepFrames && !neighbourMoving(tile))
+		{
+			SleepTile(tile);
+			changed = true;
+		}
+	}
+
+	if (changed)
+		UpdateActiveSets();
+}
+
+void ClothSolver::SleepTile(size_t tile)
+{
+	unsigned int x0, x1, y0, y1;
+	GetTileRect(tile, m_tilesX, gridRes, x0, x1, y0, y1);
+
+	// Drop the leftover velocity, so the tile wakes up at rest
+	for (unsigned int y = y0; y < y1; y++)
+		for (unsigned int x = x0; x < x1; x++)
+		{
+			const size_t i = x + y * gridRes;
+			particles.SetPrevPosition(i, particles.GetPosition(i));
+			particles.invMass[i] = 0.0f;
+		}
+
+	m_tileAsleep[tile] = 1;
+	m_sleepingTiles++;
+}
+
+void ClothSolver::WakeTile(size_t tile)
+{
+	unsigned int x0, x1, y0, y1;
+	GetTileRect(tile, m_tilesX, gridRes, x0, x1, y0, y1);
+
+	for (unsigned int y = y0; y < y1; y++)
+		for (unsigned int x = x0; x < x1; x++)
+		{
+			const size_t i = x + y * gridRes;
+			particles.invMass[i] = m_invMass[i];
+		}
+
+	m_tileAsleep[tile] = 0;
+	m_tileRestFrames[tile] = 0;
+	m_sleepingTiles--;
+}
+
+void ClothSolver::UpdateActiveSets()
+{
+	m_awakeRanges.clear();
+	m_awakeParticles = 0;
+
+	if (m_sleepingTiles == 0)
+	{
+		// Padding particles have no mass, so whole SIMD registers can be processed
+		for (size_t begin = 0; begin < particles.paddedCount; begin += MIN_PARTICLES_PER_TASK)
+			m_awakeRanges.push_back(ParticleRange{ begin, std::min<size_t>(begin + MIN_PARTICLES_PER_TASK, particles.paddedCount) });
+		m_awakeParticles = particles.paddedCount;
+	}
+	else
+	{
+		// Walk the grid row by row, merging the row segments of awake tiles that touch
+		for (unsigned int y = 0; y < gridRes; y++)
+			for (unsigned int tx = 0; tx < m_tilesX; tx++)
+			{
+				if (m_tileAsleep[tx + (y / SLEEP_TILE_SIZE) * m_tilesX])
+					continue;
+
+				const size_t begin = y * gridRes + tx * SLEEP_TILE_SIZE;
+				const size_t end = y * gridRes + std::min(tx * SLEEP_TILE_SIZE + SLEEP_TILE_SIZE, gridRes);
+
+				if (!m_awakeRanges.empty() && m_awakeRanges.back().end == begin
+					&& end - m_awakeRanges.back().begin <= MIN_PARTICLES_PER_TASK)
+					m_awakeRanges.back().end = end;
+				else
+					m_awakeRanges.push_back(ParticleRange{ begin, end });
+
+				m_awakeParticles += end - begin;
+			}
+	}
+
+	FilterActiveConstraints(particles, constraints, constraintBatches, m_activeConstraints, m_activeBatches);
+	for (size_t level = 0; level < m_levels.size(); level++)
+		FilterActiveConstraints(particles, m_levels[level].constraints, m_levels[level].batches, m_levels[level].activeConstraints, m_levels[level].activeBatches);
+}
\ No newline at end of file
@@ -0,0 +1,294 @@
+#include <ClothWorld.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <math.h>
+#include <stdexcept>
+
+ClothWorld::ClothWorld(ThreadPool& pool)
+	:
+	m_pool(pool),
+	m_accumulator(0.0f),
+	m_interpolation(0.0f),
+	m_stepped(false)
+{}
+
+ClothSolver& ClothWorld::AddCloth(float width, float depth, unsigned int wP, unsigned int dP, unsigned int gridRes, float initHeight,
+	const ClothSolverSettings& settings)
+{
+	m_cloths.emplace_back(new ClothSolver(width, depth, wP, dP, gridRes, initHeight, settings, m_pool));
+	m_bvhs.emplace_back();
+	m_deltas.emplace_back();
+	m_contacts.emplace_back();
+
+	const ClothParticles& particles = m_cloths.back()->particles;
+	m_previous.emplace_back(particles.count);
+	for (size_t i = 0; i < particles.count; i++)
+		m_previous.back()[i] = particles.GetPosition(i);
+
+	m_order.push_back(m_cloths.size() - 1);
+	std::stable_sort(m_order.begin(), m_order.end(), [&](size_t a, size_t b)
+	{
+		return m_cloths[a]->particles.count > m_cloths[b]->particles.count;
+	});
+
+	return *m_cloths.back();
+}
+
+size_t ClothWorld::GetClothCount() const
+{
+	return m_cloths.size();
+}
+
+ClothSolver& ClothWorld::GetCloth(size_t i)
+{
+	return *m_cloths[i];
+}
+
+void ClothWorld::Simulate(const std::vector<ForceField>& forceFields, const ColliderSet& colliders,
+	const std::vector<glm::mat4>& modelMatrices, float dt)
+{
+	if (modelMatrices.size() != m_cloths.size())
+	{
+		throw std::runtime_error("one model matrix per cloth expected");
+	}
+
+	m_collisionStats = ClothSolverStats();
+	m_stepped = true;
+
+	bool clothCollision = false;
+	int substeps = 0;
+	for (size_t i = 0; i < m_cloths.size(); i++)
+	{
+		clothCollision = clothCollision || m_cloths[i]->settings.clothCollision;
+		substeps = std::max(substeps, m_cloths[i]->settings.substeps);
+	}
+
+	// Independent cloths run their whole frame as one task
+	if (!clothCollision || m_cloths.size() < 2)
+	{
+		m_pool.ParallelTasks(m_order.size(), [&](size_t task)
+		{
+			const size_t cloth = m_order[task];
+			m_cloths[cloth]->Simulate(forceFields, colliders, modelMatrices[cloth], dt);
+		});
+		return;
+	}
+
+	m_pool.ParallelTasks(m_order.size(), [&](size_t task)
+	{
+		const size_t cloth = m_order[task];
+		m_cloths[cloth]->BeginFrame(forceFields, colliders, modelMatrices[cloth]);
+	});
+
+	for (int step = 0; step < substeps; step++)
+	{
+		m_pool.ParallelTasks(m_order.size(), [&](size_t task)
+		{
+			const size_t cloth = m_order[task];
+			if (step < m_cloths[cloth]->settings.substeps)
+				m_cloths[cloth]->Substep(forceFields, colliders, modelMatrices[cloth], dt);
+		});
+
+		CollideCloths(modelMatrices);
+	}
+
+	m_pool.ParallelTasks(m_order.size(), [&](size_t task)
+	{
+		m_cloths[m_order[task]]->EndFrame();
+	});
+}
+
+void ClothWorld::CollideCloths(const std::vector<glm::mat4>& modelMatrices)
+{
+	std::atomic<int> rebuilds(0);
+
+	m_pool.ParallelTasks(m_order.size(), [&](size_t task)
+	{
+		const size_t cloth = m_order[task];
+		if (m_bvhs[cloth].Update(m_cloths[cloth]->particles, m_cloths[cloth]->triIndices, modelMatrices[cloth]))
+			rebuilds++;
+	});
+
+	m_collisionStats.bvhRebuilds += rebuilds.load();
+	m_collisionStats.bvhRefits += static_cast<int>(m_cloths.size()) - rebuilds.load();
+
+	std::atomic<int> contacts(0);
+
+	// Gather: particles of one cloth against the triangles of every other one. Nothing moves yet,
+	// so each cloth sees the others as they were at the end of the substep
+	m_pool.ParallelTasks(m_order.size(), [&](size_t task)
+	{
+		const size_t a = m_order[task];
+		const ClothSolver& cloth = *m_cloths[a];
+
+		m_deltas[a].assign(cloth.particles.count, glm::vec3(0.0f));
+		m_contacts[a].assign(cloth.particles.count, 0);
+
+		const float thickness = cloth.settings.thickness;
+		if (!cloth.settings.clothCollision || thickness <= 0.0f)
+			return;
+
+		// Pushes are found in world space and stored in cloth space
+		const glm::mat3 worldToCloth = glm::inverse(glm::mat3(modelMatrices[a]));
+
+		glm::vec3 minA, maxA;
+		m_bvhs[a].GetBounds(minA, maxA);
+
+		for (size_t b = 0; b < m_cloths.size(); b++)
+		{
+			if (b == a || m_bvhs[b].IsEmpty())
+				continue;
+
+			glm::vec3 minB, maxB;
+			m_bvhs[b].GetBounds(minB, maxB);
+			if (glm::any(glm::lessThan(maxA + thickness, minB)) || glm::any(glm::greaterThan(minA - thickness, maxB)))
+				continue;
+
+			// A cloth that collides too gets the opposite push from its own query, so each side takes half.
+			// One that doesn't stays put, so this side takes all of it
+			const ClothSolverSettings& other = m_cloths[b]->settings;
+			const float share = other.clothCollision && other.thickness > 0.0f ? 0.5f : 1.0f;
+
+			m_pool.ParallelFor(cloth.particles.count, MIN_COLLISION_PARTICLES_PER_TASK, [&](size_t begin, size_t end)
+			{
+				int chunkContacts = 0;
+
+				for (size_t i = begin; i < end; i++)
+				{
+					if (cloth.particles.invMass[i] == 0.0f)
+						continue;
+
+					const glm::vec3 position = m_bvhs[a].GetPosition(i);
+
+					glm::vec3 closest, normal;
+					if (!m_bvhs[b].ClosestPoint(position, thickness, closest, normal))
+						continue;
+
+					// Cloth is two-sided: push away from the surface on whichever side the particle is
+					const glm::vec3 offset = position - closest;
+					const float distance = glm::length(offset);
+					const glm::vec3 direction = distance > 0.0f ? offset / distance : normal;
+
+					m_deltas[a][i] += worldToCloth * (direction * (share * (thickness - distance)));
+					m_contacts[a][i]++;
+					chunkContacts++;
+				}
+
+				contacts += chunkContacts;
+			});
+		}
+	});
+
+	m_collisionStats.clothContacts += contacts.load();
+	if (contacts.load() == 0)
+		return;
+
+	// Apply, averaged like self-collision so a particle touching several triangles doesn't overshoot
+	m_pool.ParallelTasks(m_order.size(), [&](size_t task)
+	{
+		const size_t cloth = m_order[task];
+		ClothParticles& particles = m_cloths[cloth]->particles;
+
+		glm::vec3 movedMin(std::numeric_limits<float>::max()), movedMax(-std::numeric_limits<float>::max());
+		for (size_t i = 0; i < particles.count; i++)
+		{
+			if (m_contacts[cloth][i] == 0)
+				continue;
+
+			const glm::vec3 position = particles.GetPosition(i) + m_deltas[cloth][i] / static_cast<float>(m_contacts[cloth][i]);
+			particles.SetPosition(i, position);
+
+			movedMin = glm::min(movedMin, position);
+			movedMax = glm::max(movedMax, position);
+		}
+
+		// Sleeping tiles that were pushed have to move again
+		if (movedMin.x <= movedMax.x)
+			m_cloths[cloth]->WakeRegion(movedMin, movedMax);
+	});
+}
+
+int ClothWorld::Advance(const std::vector<ForceField>& forceFields, const ColliderSet& colliders,
+	const std::vector<glm::mat4>& modelMatrices, float frameTime, float rate, int maxSteps)
+{
+	const double step = 1.0 / rate;
+
+	m_accumulator += std::max(frameTime, 0.0f);
+	const int steps = static_cast<int>(std::min(floor(m_accumulator / step), static_cast<double>(std::max(maxSteps, 0))));
+	m_accumulator -= steps * step;
+
+	// Whatever is still a whole step or more after the cap is dropped
+	if (m_accumulator >= step)
+		m_accumulator = fmod(m_accumulator, step);
+
+	// The stats of an earlier frame would be shown as this one's otherwise
+	m_stepped = steps > 0;
+
+	for (int s = 0; s < steps; s++)
+	{
+		// Only the state before the last step is needed to interpolate
+		if (s == steps - 1)
+		{
+			m_pool.ParallelTasks(m_cloths.size(), [&](size_t cloth)
+			{
+				const ClothParticles& particles = m_cloths[cloth]->particles;
+				m_previous[cloth].resize(particles.count);
+				for (size_t i = 0; i < particles.count; i++)
+					m_previous[cloth][i] = particles.GetPosition(i);
+			});
+		}
+
+		Simulate(forceFields, colliders, modelMatrices, static_cast<float>(step));
+	}
+
+	m_interpolation = static_cast<float>(std::min(m_accumulator / step, 1.0));
+	return steps;
+}
+
+float ClothWorld::GetInterpolation() const
+{
+	return m_interpolation;
+}
+
+void ClothWorld::GetInterpolatedPositions(size_t i, float alpha, std::vector<glm::vec3>& positions) const
+{
+	const ClothParticles& particles = m_cloths[i]->particles;
+	const std::vector<glm::vec3>& previous = m_previous[i];
+
+	positions.resize(particles.count);
+	for (size_t p = 0; p < particles.count; p++)
+		positions[p] = previous[p] + (particles.GetPosition(p) - previous[p]) * alpha;
+}
+
+ClothSolverStats ClothWorld::GetStats() const
+{
+	ClothSolverStats stats;
+
+	for (size_t i = 0; i < m_cloths.size(); i++)
+	{
+		const ClothSolverStats clothStats = m_cloths[i]->GetStats();
+		stats.sleepingTiles += clothStats.sleepingTiles;
+		stats.tiles += clothStats.tiles;
+
+		// The tiles are the cloth's current state, the rest is what the last step did
+		if (!m_stepped)
+			continue;
+
+		stats.iterations += clothStats.iterations;
+		stats.maxIterations += clothStats.maxIterations;
+		stats.residual = std::max(stats.residual, clothStats.residual);
+		stats.selfContacts += clothStats.selfContacts;
+		stats.sweptContacts += clothStats.sweptContacts;
+	}
+
+	if (!m_stepped)
+		return stats;
+
+	stats.clothContacts = m_collisionStats.clothContacts;
+	stats.bvhRefits = m_collisionStats.bvhRefits;
+	stats.bvhRebuilds = m_collisionStats.bvhRebuilds;
+
+	return stats;
+}
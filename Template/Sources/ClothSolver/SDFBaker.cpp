@@ -0,0 +1,189 @@
+#include <SDFBaker.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <math.h>
+
+// Grid samples per task when filling the coarse grid
+#define MIN_SDF_SAMPLES_PER_TASK 64
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t hash)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+bool HashFile(const std::string& path, uint64_t& hash)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	hash = FNV_OFFSET_BASIS;
+
+	char buffer[1 << 16];
+	while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+		hash = HashBytes(buffer, static_cast<size_t>(file.gcount()), hash);
+
+	return file.eof();
+}
+
+/// <summary>
+/// Distance to the nearest triangle of any mesh, negative behind the face, edge or corner it is nearest to.
+/// maxDistance if nothing is nearer
+/// </summary>
+static float SignedDistance(const std::vector<const TriangleBVH*>& meshes, glm::vec3 point, float maxDistance)
+{
+	float distance = maxDistance;
+	float sign = 1.0f;
+
+	for (size_t m = 0; m < meshes.size(); m++)
+	{
+		glm::vec3 closest, normal;
+		if (meshes[m]->ClosestPoint(point, distance, closest, normal))
+		{
+			distance = glm::length(point - closest);
+			sign = glm::dot(point - closest, normal) < 0.0f ? -1.0f : 1.0f;
+		}
+	}
+
+	return sign * distance;
+}
+
+/// <summary>
+/// Bounds of all meshes together. False if they have no triangles
+/// </summary>
+static bool GetMeshBounds(const std::vector<const TriangleBVH*>& meshes, glm::vec3& min, glm::vec3& max)
+{
+	min = glm::vec3(std::numeric_limits<float>::max());
+	max = glm::vec3(-std::numeric_limits<float>::max());
+
+	for (size_t m = 0; m < meshes.size(); m++)
+	{
+		if (meshes[m]->IsEmpty())
+			continue;
+
+		glm::vec3 meshMin, meshMax;
+		meshes[m]->GetBounds(meshMin, meshMax);
+		min = glm::min(min, meshMin);
+		max = glm::max(max, meshMax);
+	}
+
+	return min.x <= max.x;
+}
+
+void BakeSDF(const std::vector<const TriangleBVH*>& meshes, float cellSize, float band, SDFGrid& grid, ThreadPool& pool)
+{
+	glm::vec3 min, max;
+	if (!GetMeshBounds(meshes, min, max))
+	{
+		grid = SDFGrid();
+		return;
+	}
+
+	// Room for the band, and a cell to spare, on every side
+	const float padding = band + cellSize;
+	const float brickSize = cellSize * SDF_BRICK_SIZE;
+	const glm::ivec3 bricks = glm::ivec3(glm::ceil((max - min + 2.0f * padding) / brickSize));
+	grid.Reset(min - padding, cellSize, bricks);
+
+	const glm::vec3 origin = grid.GetOrigin();
+	const float halfDiagonal = 0.5f * sqrtf(3.0f) * brickSize;
+	const float infinity = std::numeric_limits<float>::infinity();
+
+	// Coarse samples at the brick corners, exact but far apart
+	const glm::ivec3 corners = bricks + 1;
+	pool.ParallelFor(static_cast<size_t>(corners.x) * corners.y * corners.z, MIN_SDF_SAMPLES_PER_TASK, [&](size_t begin, size_t end)
+	{
+		for (size_t c = begin; c < end; c++)
+		{
+			const int i = static_cast<int>(c % corners.x), j = static_cast<int>((c / corners.x) % corners.y), k = static_cast<int>(c / corners.x / corners.y);
+			grid.Coarse(i, j, k) = SignedDistance(meshes, origin + glm::vec3(i, j, k) * brickSize, infinity);
+		}
+	});
+
+	// A brick can only reach within band of the surface if its center is within half a diagonal more
+	const size_t slots = static_cast<size_t>(bricks.x) * bricks.y * bricks.z;
+	std::vector<float> centers(slots);
+	pool.ParallelFor(slots, MIN_SDF_SAMPLES_PER_TASK, [&](size_t begin, size_t end)
+	{
+		for (size_t b = begin; b < end; b++)
+		{
+			const glm::ivec3 brick(static_cast<int>(b % bricks.x), static_cast<int>((b / bricks.x) % bricks.y), static_cast<int>(b / bricks.x / bricks.y));
+			centers[b] = SignedDistance(meshes, origin + (glm::vec3(brick) + 0.5f) * brickSize, infinity);
+		}
+	});
+
+	// Allocated in slot order, so the layout doesn't depend on the thread count
+	std::vector<glm::ivec3> fineBricks;
+	for (size_t b = 0; b < slots; b++)
+	{
+		if (fabsf(centers[b]) < halfDiagonal + band)
+		{
+			const glm::ivec3 brick(static_cast<int>(b % bricks.x), static_cast<int>((b / bricks.x) % bricks.y), static_cast<int>(b / bricks.x / bricks.y));
+			grid.AddBrick(brick.x, brick.y, brick.z);
+			fineBricks.push_back(brick);
+		}
+	}
+
+	// Every fine sample is within a diagonal plus band of the surface
+	const float maxDistance = 2.0f * halfDiagonal + band + cellSize;
+	const int stride = SDF_BRICK_SIZE + 1;
+
+	pool.ParallelFor(fineBricks.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t b = begin; b < end; b++)
+		{
+			const glm::ivec3 brick = fineBricks[b];
+			const glm::vec3 corner = origin + glm::vec3(brick) * brickSize;
+			float* samples = grid.GetBrick(grid.FindBrick(brick.x, brick.y, brick.z));
+
+			for (int k = 0; k < stride; k++)
+				for (int j = 0; j < stride; j++)
+					for (int i = 0; i < stride; i++)
+						samples[(k * stride + j) * stride + i] = SignedDistance(meshes, corner + glm::vec3(i, j, k) * cellSize, maxDistance);
+		}
+	});
+}
+
+bool LoadOrBakeSDF(const std::vector<const TriangleBVH*>& meshes, const std::string& sourcePath, const std::string& cachePath, SDFGrid& grid,
+	ThreadPool& pool)
+{
+	glm::vec3 min, max;
+	if (!GetMeshBounds(meshes, min, max))
+	{
+		grid = SDFGrid();
+		return false;
+	}
+
+	const glm::vec3 extent = max - min;
+	const float cellSize = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-4f)) / SDF_BAKE_RESOLUTION;
+	const float band = cellSize * SDF_BAKE_BAND;
+
+	// The key covers the source file and everything the bake depends on
+	uint64_t key;
+	const bool hashed = HashFile(sourcePath, key);
+	if (hashed)
+	{
+		const int settings[4] = { SDF_BAKE_VERSION, SDF_BAKE_RESOLUTION, SDF_BAKE_BAND, SDF_BRICK_SIZE };
+		key = HashBytes(settings, sizeof(settings), key);
+
+		if (grid.Load(cachePath, key))
+			return true;
+	}
+
+	BakeSDF(meshes, cellSize, band, grid, pool);
+
+	if (hashed && !grid.Save(cachePath, key))
+		std::cout << "ERROR::SDF:: could not write " << cachePath << std::endl;
+
+	return false;
+}
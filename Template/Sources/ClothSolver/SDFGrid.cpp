@@ -0,0 +1,201 @@
+#include <SDFGrid.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+// Bumped whenever the file layout changes, so old caches are baked again
+#define SDF_FILE_VERSION 1
+
+static const char sdfFileMagic[4] = { 'S', 'D', 'F', 'G' };
+
+/// <summary>
+/// Trilinear interpolation of the corners c[x + 2y + 4z] of a cell at t in [0, 1]^3, and its gradient
+/// </summary>
+static inline float Trilinear(const float c[8], glm::vec3 t, float cellSize, glm::vec3& gradient)
+{
+	// Interpolate along x, then y, then z
+	const float c00 = c[0] + (c[1] - c[0]) * t.x, c10 = c[2] + (c[3] - c[2]) * t.x;
+	const float c01 = c[4] + (c[5] - c[4]) * t.x, c11 = c[6] + (c[7] - c[6]) * t.x;
+	const float c0 = c00 + (c10 - c00) * t.y, c1 = c01 + (c11 - c01) * t.y;
+
+	// Derivative of the same interpolation
+	const float dx00 = c[1] - c[0], dx10 = c[3] - c[2], dx01 = c[5] - c[4], dx11 = c[7] - c[6];
+	const float dx0 = dx00 + (dx10 - dx00) * t.y, dx1 = dx01 + (dx11 - dx01) * t.y;
+	gradient.x = (dx0 + (dx1 - dx0) * t.z) / cellSize;
+	gradient.y = ((c10 - c00) + ((c11 - c01) - (c10 - c00)) * t.z) / cellSize;
+	gradient.z = (c1 - c0) / cellSize;
+
+	return c0 + (c1 - c0) * t.z;
+}
+
+SDFGrid::SDFGrid()
+	:
+	m_origin(0.0f),
+	m_cellSize(1.0f),
+	m_bricks(0)
+{}
+
+void SDFGrid::Reset(glm::vec3 origin, float cellSize, glm::ivec3 bricks)
+{
+	m_origin = origin;
+	m_cellSize = cellSize;
+	m_bricks = glm::max(bricks, glm::ivec3(1));
+	m_coarse.assign(static_cast<size_t>(m_bricks.x + 1) * (m_bricks.y + 1) * (m_bricks.z + 1), 0.0f);
+	m_brickTable.assign(static_cast<size_t>(m_bricks.x) * m_bricks.y * m_bricks.z, SDF_NO_BRICK);
+	m_samples.clear();
+}
+
+bool SDFGrid::IsEmpty() const
+{
+	return m_coarse.empty();
+}
+
+uint32_t SDFGrid::AddBrick(int i, int j, int k)
+{
+	uint32_t& slot = m_brickTable[(static_cast<size_t>(k) * m_bricks.y + j) * m_bricks.x + i];
+	if (slot == SDF_NO_BRICK)
+	{
+		slot = static_cast<uint32_t>(m_samples.size() / SDF_BRICK_SAMPLES);
+		m_samples.resize(m_samples.size() + SDF_BRICK_SAMPLES, 0.0f);
+	}
+
+	return slot;
+}
+
+size_t SDFGrid::GetBrickCount() const
+{
+	return m_samples.size() / SDF_BRICK_SAMPLES;
+}
+
+glm::vec3 SDFGrid::GetOrigin() const
+{
+	return m_origin;
+}
+
+float SDFGrid::GetCellSize() const
+{
+	return m_cellSize;
+}
+
+glm::ivec3 SDFGrid::GetBricks() const
+{
+	return m_bricks;
+}
+
+void SDFGrid::GetBounds(glm::vec3& min, glm::vec3& max) const
+{
+	min = m_origin;
+	max = m_origin + glm::vec3(m_bricks * SDF_BRICK_SIZE) * m_cellSize;
+}
+
+bool SDFGrid::Sample(glm::vec3 point, float& distance, glm::vec3& gradient) const
+{
+	if (m_coarse.empty())
+		return false;
+
+	const glm::vec3 cell = (point - m_origin) / m_cellSize;
+	if (glm::any(glm::lessThan(cell, glm::vec3(0.0f))) || glm::any(glm::greaterThan(cell, glm::vec3(m_bricks * SDF_BRICK_SIZE))))
+		return false;
+
+	// Last brick along each axis for points on the far faces
+	const glm::ivec3 brick = glm::min(glm::ivec3(cell / static_cast<float>(SDF_BRICK_SIZE)), m_bricks - 1);
+	const glm::vec3 local = cell - glm::vec3(brick * SDF_BRICK_SIZE);
+
+	float corners[8];
+	const uint32_t index = FindBrick(brick.x, brick.y, brick.z);
+	if (index == SDF_NO_BRICK)
+	{
+		// Far from the surface, the brick corners are close enough
+		for (int c = 0; c < 8; c++)
+			corners[c] = Coarse(brick.x + (c & 1), brick.y + ((c >> 1) & 1), brick.z + (c >> 2));
+
+		distance = Trilinear(corners, local / static_cast<float>(SDF_BRICK_SIZE), m_cellSize * SDF_BRICK_SIZE, gradient);
+		return true;
+	}
+
+	const int stride = SDF_BRICK_SIZE + 1;
+	const glm::ivec3 base = glm::min(glm::ivec3(local), glm::ivec3(SDF_BRICK_SIZE - 1));
+	const float* samples = m_samples.data() + static_cast<size_t>(index) * SDF_BRICK_SAMPLES;
+
+	for (int c = 0; c < 8; c++)
+		corners[c] = samples[((base.z + (c >> 2)) * stride + base.y + ((c >> 1) & 1)) * stride + base.x + (c & 1)];
+
+	distance = Trilinear(corners, local - glm::vec3(base), m_cellSize, gradient);
+	return true;
+}
+
+bool SDFGrid::Save(const std::string& path, uint64_t key) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+
+	const uint32_t version = SDF_FILE_VERSION;
+	const uint32_t brickCount = static_cast<uint32_t>(GetBrickCount());
+
+	file.write(sdfFileMagic, sizeof(sdfFileMagic));
+	file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+	file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+	file.write(reinterpret_cast<const char*>(&m_origin), sizeof(m_origin));
+	file.write(reinterpret_cast<const char*>(&m_cellSize), sizeof(m_cellSize));
+	file.write(reinterpret_cast<const char*>(&m_bricks), sizeof(m_bricks));
+	file.write(reinterpret_cast<const char*>(&brickCount), sizeof(brickCount));
+	file.write(reinterpret_cast<const char*>(m_coarse.data()), m_coarse.size() * sizeof(float));
+	file.write(reinterpret_cast<const char*>(m_brickTable.data()), m_brickTable.size() * sizeof(uint32_t));
+	file.write(reinterpret_cast<const char*>(m_samples.data()), m_samples.size() * sizeof(float));
+
+	return static_cast<bool>(file);
+}
+
+bool SDFGrid::Load(const std::string& path, uint64_t key)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	char magic[4];
+	uint32_t version, brickCount;
+	uint64_t fileKey;
+	glm::vec3 origin;
+	float cellSize;
+	glm::ivec3 bricks;
+
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(&version), sizeof(version));
+	file.read(reinterpret_cast<char*>(&fileKey), sizeof(fileKey));
+	file.read(reinterpret_cast<char*>(&origin), sizeof(origin));
+	file.read(reinterpret_cast<char*>(&cellSize), sizeof(cellSize));
+	file.read(reinterpret_cast<char*>(&bricks), sizeof(bricks));
+	file.read(reinterpret_cast<char*>(&brickCount), sizeof(brickCount));
+
+	if (!file || memcmp(magic, sdfFileMagic, sizeof(magic)) != 0 || version != SDF_FILE_VERSION || fileKey != key
+		|| !(cellSize > 0.0f) || glm::any(glm::lessThan(bricks, glm::ivec3(1))) || glm::any(glm::greaterThan(bricks, glm::ivec3(4096))))
+		return false;
+
+	std::vector<float> coarse(static_cast<size_t>(bricks.x + 1) * (bricks.y + 1) * (bricks.z + 1));
+	std::vector<uint32_t> brickTable(static_cast<size_t>(bricks.x) * bricks.y * bricks.z);
+	if (brickCount > brickTable.size())
+		return false;
+
+	std::vector<float> samples(static_cast<size_t>(brickCount) * SDF_BRICK_SAMPLES);
+
+	file.read(reinterpret_cast<char*>(coarse.data()), coarse.size() * sizeof(float));
+	file.read(reinterpret_cast<char*>(brickTable.data()), brickTable.size() * sizeof(uint32_t));
+	file.read(reinterpret_cast<char*>(samples.data()), samples.size() * sizeof(float));
+	if (!file)
+		return false;
+
+	for (size_t i = 0; i < brickTable.size(); i++)
+		if (brickTable[i] != SDF_NO_BRICK && brickTable[i] >= brickCount)
+			return false;
+
+	m_origin = origin;
+	m_cellSize = cellSize;
+	m_bricks = bricks;
+	m_coarse.swap(coarse);
+	m_brickTable.swap(brickTable);
+	m_samples.swap(samples);
+
+	return true;
+}
@@ -0,0 +1,233 @@
+#include <ThreadPool.hpp>
+
+#include <algorithm>
+
+// Pool and queue the current thread works for, set once per worker thread
+static thread_local const ThreadPool* t_pool = nullptr;
+static thread_local size_t t_queue = 0;
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+	:
+	m_generation(0),
+	m_sleeping(0),
+	m_quit(false)
+{
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		m_queues.emplace_back(new WorkQueue());
+
+	// The thread calling ParallelFor does its share of the work
+	for (unsigned int i = 1; i < threadCount; i++)
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+		m_workers[i].join();
+}
+
+unsigned int ThreadPool::GetThreadCount() const
+{
+	return static_cast<unsigned int>(m_workers.size()) + 1;
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& fn)
+{
+	if (count == 0)
+		return;
+
+	// Rounding the chunk count down keeps every chunk at least minChunk long
+	const size_t maxChunks = count / std::max<size_t>(minChunk, 1);
+	const size_t chunkCount = std::min<size_t>(static_cast<size_t>(GetThreadCount()) * CHUNKS_PER_THREAD, maxChunks);
+
+	// Not worth waking anyone up, or nobody to wake
+	if (chunkCount <= 1 || m_workers.empty())
+	{
+		fn(0, count);
+		return;
+	}
+
+	Job job;
+	job.fn = &fn;
+	job.count = count;
+	job.chunkCount = chunkCount;
+	job.nextChunk = 0;
+	job.finishedChunks.store(0);
+	job.done = false;
+
+	RunJob(job);
+}
+
+void ThreadPool::ParallelTasks(size_t count, const std::function<void(size_t)>& fn)
+{
+	if (count == 0)
+		return;
+
+	if (count == 1 || m_workers.empty())
+	{
+		for (size_t i = 0; i < count; i++)
+			fn(i);
+		return;
+	}
+
+	// One chunk per task
+	const std::function<void(size_t, size_t)> chunkFn = [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			fn(i);
+	};
+
+	Job job;
+	job.fn = &chunkFn;
+	job.count = count;
+	job.chunkCount = count;
+	job.nextChunk = 0;
+	job.finishedChunks.store(0);
+	job.done = false;
+
+	RunJob(job);
+}
+
+ThreadPool& ThreadPool::Default()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::RunJob(Job& job)
+{
+	const size_t ownQueue = GetLocalQueue();
+
+	{
+		std::lock_guard<std::mutex> lock(m_queues[ownQueue]->mutex);
+		m_queues[ownQueue]->jobs.push_back(&job);
+	}
+
+	// This thread takes one chunk itself, sleepers are woken for the rest
+	unsigned int wake, sleeping;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_generation.fetch_add(1);
+		sleeping = m_sleeping;
+		wake = static_cast<unsigned int>(std::min<size_t>(sleeping, job.chunkCount - 1));
+	}
+
+	// One call when everybody is needed anyway
+	if (wake == sleeping)
+		m_wake.notify_all();
+	else
+		for (unsigned int i = 0; i < wake; i++)
+			m_wake.notify_one();
+
+	// Help out until every chunk of the job is claimed. Our own queue comes first, so the job's
+	// chunks (and loops nested inside them) are preferred over stealing unrelated work
+	while (job.finishedChunks.load() < job.chunkCount && RunAnyChunk(ownQueue))
+		;
+
+	// Everything left is running on other threads. Waiting under the job's mutex also keeps the job alive
+	// until the thread finishing the last chunk is done with it
+	std::unique_lock<std::mutex> lock(job.mutex);
+	job.finished.wait(lock, [&] { return job.done; });
+
+	if (job.error)
+		std::rethrow_exception(job.error);
+}
+
+bool ThreadPool::RunChunk(WorkQueue& queue, bool newest)
+{
+	Job* job;
+	size_t chunk;
+
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+			return false;
+
+		job = newest ? queue.jobs.back() : queue.jobs.front();
+		chunk = job->nextChunk++;
+
+		// Fully claimed jobs leave the queue, so nobody looks at them after they are finished
+		if (job->nextChunk == job->chunkCount)
+		{
+			if (newest)
+				queue.jobs.pop_back();
+			else
+				queue.jobs.pop_front();
+		}
+	}
+
+	// Fixed boundaries, whichever thread picks the chunk up
+	const size_t begin = job->count * chunk / job->chunkCount;
+	const size_t end = job->count * (chunk + 1) / job->chunkCount;
+	try
+	{
+		(*job->fn)(begin, end);
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		if (!job->error)
+			job->error = std::current_exception();
+	}
+
+	// Only the last chunk wakes the caller. Once a chunk has landed the job may be gone unless it was the last,
+	// whose caller waits for the lock to be released
+	const size_t chunkCount = job->chunkCount;
+	if (job->finishedChunks.fetch_add(1) + 1 == chunkCount)
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->done = true;
+		job->finished.notify_one();
+	}
+
+	return true;
+}
+
+bool ThreadPool::RunAnyChunk(size_t ownQueue)
+{
+	if (RunChunk(*m_queues[ownQueue], true))
+		return true;
+
+	for (size_t i = 1; i < m_queues.size(); i++)
+		if (RunChunk(*m_queues[(ownQueue + i) % m_queues.size()], false))
+			return true;
+
+	return false;
+}
+
+size_t ThreadPool::GetLocalQueue() const
+{
+	return t_pool == this ? t_queue : 0;
+}
+
+void ThreadPool::WorkerLoop(size_t queue)
+{
+	t_pool = this;
+	t_queue = queue;
+
+	while (true)
+	{
+		// Read before looking for work: a job pushed after the queues were checked changes it
+		const uint64_t generation = m_generation.load();
+
+		if (RunAnyChunk(queue))
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_sleeping++;
+		m_wake.wait(lock, [&] { return m_quit || m_generation.load() != generation; });
+		m_sleeping--;
+
+		if (m_quit)
+			return;
+	}
+}
@@ -0,0 +1,464 @@
+#include <TriangleBVH.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <numeric>
+#include <utility>
+
+glm::vec3 ClosestPointOnTriangle(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+	TriangleFeature feature;
+	return ClosestPointOnTriangle(p, a, b, c, feature);
+}
+
+glm::vec3 ClosestPointOnTriangle(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c, TriangleFeature& feature)
+{
+	// Voronoi region tests, see Ericson - Real-Time Collision Detection, 5.1.5
+	const glm::vec3 ab = b - a;
+	const glm::vec3 ac = c - a;
+	const glm::vec3 ap = p - a;
+
+	const float d1 = glm::dot(ab, ap);
+	const float d2 = glm::dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		feature = TriangleFeature::CORNER_A;
+		return a;
+	}
+
+	const glm::vec3 bp = p - b;
+	const float d3 = glm::dot(ab, bp);
+	const float d4 = glm::dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3)
+	{
+		feature = TriangleFeature::CORNER_B;
+		return b;
+	}
+
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		feature = TriangleFeature::EDGE_AB;
+		return a + ab * (d1 / (d1 - d3));
+	}
+
+	const glm::vec3 cp = p - c;
+	const float d5 = glm::dot(ab, cp);
+	const float d6 = glm::dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6)
+	{
+		feature = TriangleFeature::CORNER_C;
+		return c;
+	}
+
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		feature = TriangleFeature::EDGE_CA;
+		return a + ac * (d2 / (d2 - d6));
+	}
+
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		feature = TriangleFeature::EDGE_BC;
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+
+	// Inside the face
+	feature = TriangleFeature::FACE;
+	const float denominator = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+/// <summary>
+/// An id per position, shared by positions that are exactly equal: meshes often repeat vertices along texture seams
+/// </summary>
+static std::vector<uint32_t> WeldPositions(const std::vector<glm::vec3>& positions)
+{
+	const auto less = [&](uint32_t i, uint32_t j)
+	{
+		const glm::vec3 p = positions[i], q = positions[j];
+		return p.x != q.x ? p.x < q.x : (p.y != q.y ? p.y < q.y : p.z < q.z);
+	};
+
+	std::vector<uint32_t> order(positions.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), less);
+
+	std::vector<uint32_t> ids(positions.size());
+	for (size_t i = 0; i < order.size(); i++)
+		ids[order[i]] = i > 0 && !less(order[i - 1], order[i]) ? ids[order[i - 1]] : order[i];
+
+	return ids;
+}
+
+/// <summary>
+/// Key of the edge between two welded vertices, the same in both directions
+/// </summary>
+static inline uint64_t EdgeKey(uint32_t i, uint32_t j)
+{
+	return static_cast<uint64_t>(std::min(i, j)) << 32 | std::max(i, j);
+}
+
+/// <summary>
+/// Angle between the edges from a to b and from a to c
+/// </summary>
+static inline float CornerAngle(glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+	return acosf(glm::clamp(glm::dot(glm::normalize(b - a), glm::normalize(c - a)), -1.0f, 1.0f));
+}
+
+/// <summary>
+/// sum scaled to unit length, or fallback if it is zero (e.g. two faces back to back)
+/// </summary>
+static inline glm::vec3 UnitOr(glm::vec3 sum, glm::vec3 fallback)
+{
+	const float length = glm::length(sum);
+	return length > 0.0f ? sum / length : fallback;
+}
+
+TriangleBVH::TriangleBVH()
+{}
+
+void TriangleBVH::Build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices)
+{
+	m_nodes.clear();
+	m_corners.clear();
+	m_normals.clear();
+	m_featureNormals.clear();
+
+	// Degenerate triangles have no face normal to push particles out along, and their edges are shared
+	// with the proper triangles around them anyway. Slivers left by rounding (e.g. at the poles of a sphere)
+	// have a normal that is mostly noise, so the area is compared to the longest edge
+	std::vector<uint32_t> triangles;
+	for (size_t t = 0; t + 2 < indices.size(); t += 3)
+	{
+		const glm::vec3 a = positions[indices[t]], b = positions[indices[t + 1]], c = positions[indices[t + 2]];
+		const float longest = std::max(glm::dot(b - a, b - a), std::max(glm::dot(c - b, c - b), glm::dot(a - c, a - c)));
+		if (glm::length(glm::cross(b - a, c - a)) > BVH_SLIVER_RATIO * longest)
+			triangles.push_back(static_cast<uint32_t>(t / 3));
+	}
+
+	const size_t triangleCount = triangles.size();
+	if (triangleCount == 0)
+		return;
+
+	// Corners are needed for the node bounds while building, in the original triangle order until the end
+	m_corners.resize(triangleCount * 3);
+	std::vector<glm::vec3> centroids(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+			m_corners[t * 3 + corner] = positions[indices[triangles[t] * 3 + corner]];
+
+		centroids[t] = (m_corners[t * 3] + m_corners[t * 3 + 1] + m_corners[t * 3 + 2]) / 3.0f;
+	}
+
+	std::vector<uint32_t> order(triangleCount);
+	std::iota(order.begin(), order.end(), 0);
+
+	// A binary tree with leaves of at least half BVH_LEAF_SIZE triangles stays below this
+	m_nodes.reserve(4 * triangleCount / BVH_LEAF_SIZE + 1);
+	m_nodes.push_back(BVHNode());
+
+	BuildNode(0, 0, static_cast<uint32_t>(triangleCount), centroids, order);
+
+	// Angle weighted pseudonormals (Baerentzen and Aanaes): a point nearest to an edge or corner is behind it only if
+	// it is behind the faces around it taken together, whichever of them the closest point search finds
+	const std::vector<uint32_t> welded = WeldPositions(positions);
+	std::vector<glm::vec3> cornerSums(positions.size(), glm::vec3(0.0f));
+	std::vector<std::pair<uint64_t, glm::vec3>> edgeSums;
+	edgeSums.reserve(triangleCount * 3);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		const glm::vec3* corners = &m_corners[t * 3];
+		const unsigned int* triangle = &indices[triangles[t] * 3];
+		const glm::vec3 normal = glm::normalize(glm::cross(corners[1] - corners[0], corners[2] - corners[0]));
+
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const int next = (corner + 1) % 3, previous = (corner + 2) % 3;
+			cornerSums[welded[triangle[corner]]] += normal * CornerAngle(corners[corner], corners[next], corners[previous]);
+			edgeSums.push_back(std::make_pair(EdgeKey(welded[triangle[corner]], welded[triangle[next]]), normal));
+		}
+	}
+
+	// One entry per edge, with the normals of all its faces summed
+	const auto edgeLess = [](const std::pair<uint64_t, glm::vec3>& edge, uint64_t key) { return edge.first < key; };
+	std::sort(edgeSums.begin(), edgeSums.end(), [](const std::pair<uint64_t, glm::vec3>& a, const std::pair<uint64_t, glm::vec3>& b)
+	{
+		return a.first < b.first;
+	});
+
+	size_t edgeCount = 0;
+	for (size_t e = 0; e < edgeSums.size(); e++)
+	{
+		if (edgeCount > 0 && edgeSums[edgeCount - 1].first == edgeSums[e].first)
+			edgeSums[edgeCount - 1].second += edgeSums[e].second;
+		else
+			edgeSums[edgeCount++] = edgeSums[e];
+	}
+	edgeSums.resize(edgeCount);
+
+	// Store the triangles in leaf order, so a leaf reads one contiguous block
+	std::vector<glm::vec3> sortedCorners(triangleCount * 3);
+	m_normals.resize(triangleCount);
+	m_featureNormals.resize(triangleCount * 6);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		const glm::vec3 a = m_corners[order[t] * 3];
+		const glm::vec3 b = m_corners[order[t] * 3 + 1];
+		const glm::vec3 c = m_corners[order[t] * 3 + 2];
+
+		sortedCorners[t * 3] = a;
+		sortedCorners[t * 3 + 1] = b;
+		sortedCorners[t * 3 + 2] = c;
+
+		m_normals[t] = glm::normalize(glm::cross(b - a, c - a));
+
+		const unsigned int* triangle = &indices[triangles[order[t]] * 3];
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const uint32_t id = welded[triangle[corner]], nextId = welded[triangle[(corner + 1) % 3]];
+			const auto edge = std::lower_bound(edgeSums.begin(), edgeSums.end(), EdgeKey(id, nextId), edgeLess);
+
+			m_featureNormals[t * 6 + static_cast<int>(TriangleFeature::CORNER_A) + corner] = UnitOr(cornerSums[id], m_normals[t]);
+			m_featureNormals[t * 6 + static_cast<int>(TriangleFeature::EDGE_AB) + corner] = UnitOr(edge->second, m_normals[t]);
+		}
+	}
+
+	m_corners.swap(sortedCorners);
+}
+
+void TriangleBVH::BuildNode(uint32_t node, uint32_t first, uint32_t count, const std::vector<glm::vec3>& centroids,
+	std::vector<uint32_t>& order)
+{
+	glm::vec3 min = m_corners[order[first] * 3], max = min;
+	glm::vec3 centroidMin = centroids[order[first]], centroidMax = centroidMin;
+
+	for (uint32_t t = first; t < first + count; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			min = glm::min(min, m_corners[order[t] * 3 + corner]);
+			max = glm::max(max, m_corners[order[t] * 3 + corner]);
+		}
+
+		centroidMin = glm::min(centroidMin, centroids[order[t]]);
+		centroidMax = glm::max(centroidMax, centroids[order[t]]);
+	}
+
+	m_nodes[node].min = min;
+	m_nodes[node].max = max;
+
+	const glm::vec3 extent = centroidMax - centroidMin;
+	const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+	// Small enough, or nothing left to split by
+	if (count <= BVH_LEAF_SIZE || extent[axis] <= 0.0f)
+	{
+		m_nodes[node].first = first;
+		m_nodes[node].count = count;
+		return;
+	}
+
+	const uint32_t half = count / 2;
+	std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count, [&](uint32_t a, uint32_t b)
+	{
+		return centroids[a][axis] < centroids[b][axis];
+	});
+
+	const uint32_t children = static_cast<uint32_t>(m_nodes.size());
+	m_nodes.push_back(BVHNode());
+	m_nodes.push_back(BVHNode());
+
+	m_nodes[node].first = children;
+	m_nodes[node].count = 0;
+
+	BuildNode(children, first, half, centroids, order);
+	BuildNode(children + 1, first + half, count - half, centroids, order);
+}
+
+bool TriangleBVH::IsEmpty() const
+{
+	return m_nodes.empty();
+}
+
+size_t TriangleBVH::GetTriangleCount() const
+{
+	return m_normals.size();
+}
+
+void TriangleBVH::GetBounds(glm::vec3& min, glm::vec3& max) const
+{
+	if (m_nodes.empty())
+	{
+		min = max = glm::vec3(0.0f);
+		return;
+	}
+
+	min = m_nodes[0].min;
+	max = m_nodes[0].max;
+}
+
+float RayBoxEntry(glm::vec3 origin, glm::vec3 inverseDirection, glm::vec3 min, glm::vec3 max)
+{
+	// Slabs; a zero direction component gives infinities that drop out of the min and max
+	const glm::vec3 t0 = (min - origin) * inverseDirection;
+	const glm::vec3 t1 = (max - origin) * inverseDirection;
+	const glm::vec3 entries = glm::min(t0, t1), exits = glm::max(t0, t1);
+
+	const float entry = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+	const float exit = std::min(std::min(exits.x, exits.y), exits.z);
+
+	return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+}
+
+bool TriangleBVH::ClosestPoint(glm::vec3 point, float maxDistance, glm::vec3& closest, glm::vec3& normal) const
+{
+	if (m_nodes.empty())
+		return false;
+
+	float best = maxDistance * maxDistance;
+	bool found = false;
+
+	// Nodes still to visit, with the distance of their box measured when they were pushed
+	uint32_t stack[BVH_STACK_SIZE];
+	float stackDistance[BVH_STACK_SIZE];
+	int top = 0;
+	stack[top] = 0;
+	stackDistance[top++] = DistanceSquaredToBox(point, m_nodes[0].min, m_nodes[0].max);
+
+	while (top > 0)
+	{
+		top--;
+		if (stackDistance[top] >= best)
+			continue;
+
+		const BVHNode& node = m_nodes[stack[top]];
+		if (node.count > 0)
+		{
+			for (uint32_t t = node.first; t < node.first + node.count; t++)
+			{
+				TriangleFeature feature;
+				const glm::vec3 candidate = ClosestPointOnTriangle(point, m_corners[t * 3], m_corners[t * 3 + 1], m_corners[t * 3 + 2], feature);
+				const glm::vec3 offset = point - candidate;
+				const float distanceSquared = glm::dot(offset, offset);
+
+				if (distanceSquared < best)
+				{
+					best = distanceSquared;
+					closest = candidate;
+					normal = feature == TriangleFeature::FACE ? m_normals[t] : m_featureNormals[t * 6 + static_cast<int>(feature)];
+					found = true;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first, it is the more likely to shrink the search radius
+		const uint32_t left = node.first, right = node.first + 1;
+		const float leftDistance = DistanceSquaredToBox(point, m_nodes[left].min, m_nodes[left].max);
+		const float rightDistance = DistanceSquaredToBox(point, m_nodes[right].min, m_nodes[right].max);
+		const bool leftFirst = leftDistance <= rightDistance;
+
+		if (std::max(leftDistance, rightDistance) < best)
+		{
+			stack[top] = leftFirst ? right : left;
+			stackDistance[top++] = std::max(leftDistance, rightDistance);
+		}
+		if (std::min(leftDistance, rightDistance) < best)
+		{
+			stack[top] = leftFirst ? left : right;
+			stackDistance[top++] = std::min(leftDistance, rightDistance);
+		}
+	}
+
+	return found;
+}
+
+bool TriangleBVH::Raycast(glm::vec3 origin, glm::vec3 direction, float maxT, float& t, glm::vec3& normal, bool frontFacesOnly) const
+{
+	if (m_nodes.empty())
+		return false;
+
+	const glm::vec3 inverseDirection = 1.0f / direction;
+	float best = maxT;
+	bool found = false;
+
+	// Nodes still to visit, with where the ray entered their box when they were pushed
+	uint32_t stack[BVH_STACK_SIZE];
+	float stackEntry[BVH_STACK_SIZE];
+	int top = 0;
+	stack[top] = 0;
+	stackEntry[top++] = RayBoxEntry(origin, inverseDirection, m_nodes[0].min, m_nodes[0].max);
+
+	while (top > 0)
+	{
+		top--;
+		if (stackEntry[top] > best)
+			continue;
+
+		const BVHNode& node = m_nodes[stack[top]];
+		if (node.count > 0)
+		{
+			for (uint32_t triangle = node.first; triangle < node.first + node.count; triangle++)
+			{
+				if (frontFacesOnly && glm::dot(direction, m_normals[triangle]) >= 0.0f)
+					continue;
+
+				// Moller-Trumbore
+				const glm::vec3 a = m_corners[triangle * 3];
+				const glm::vec3 ab = m_corners[triangle * 3 + 1] - a, ac = m_corners[triangle * 3 + 2] - a;
+				const glm::vec3 p = glm::cross(direction, ac);
+				const float determinant = glm::dot(ab, p);
+				if (determinant == 0.0f)
+					continue;
+
+				const float inverseDeterminant = 1.0f / determinant;
+				const glm::vec3 ao = origin - a;
+				const float u = glm::dot(ao, p) * inverseDeterminant;
+				if (u < 0.0f || u > 1.0f)
+					continue;
+
+				const glm::vec3 q = glm::cross(ao, ab);
+				const float v = glm::dot(direction, q) * inverseDeterminant;
+				if (v < 0.0f || u + v > 1.0f)
+					continue;
+
+				const float hit = glm::dot(ac, q) * inverseDeterminant;
+				if (hit >= 0.0f && hit <= best)
+				{
+					best = hit;
+					normal = m_normals[triangle];
+					found = true;
+				}
+			}
+			continue;
+		}
+
+		// Visit the child the ray enters first first
+		const uint32_t left = node.first, right = node.first + 1;
+		const float leftEntry = RayBoxEntry(origin, inverseDirection, m_nodes[left].min, m_nodes[left].max);
+		const float rightEntry = RayBoxEntry(origin, inverseDirection, m_nodes[right].min, m_nodes[right].max);
+		const bool leftFirst = leftEntry <= rightEntry;
+
+		if (std::max(leftEntry, rightEntry) <= best)
+		{
+			stack[top] = leftFirst ? right : left;
+			stackEntry[top++] = std::max(leftEntry, rightEntry);
+		}
+		if (std::min(leftEntry, rightEntry) <= best)
+		{
+			stack[top] = leftFirst ? left : right;
+			stackEntry[top++] = std::min(leftEntry, rightEntry);
+		}
+	}
+
+	if (found)
+		t = best;
+
+	return found;
+}
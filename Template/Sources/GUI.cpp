@@ -1,5 +1,7 @@
 #include <GUI.hpp>
 
+#include <glm/gtc/type_ptr.hpp>
+
 GUI::GUI(GLFWwindow* pWindow, Camera& camera, SceneSettings& sceneSettings, Timer& timer)
     :
     p_window(pWindow),
@@ -11,7 +13,7 @@ GUI::GUI(GLFWwindow* pWindow, Camera& camera, SceneSettings& sceneSettings, Time
     //
 }
 
-void GUI::Init(size_t nModels)
+void GUI::Init(size_t nModels, size_t nCloths)
 {
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -33,11 +35,17 @@ void GUI::Init(size_t nModels)
     modelSets[2].scale[1] = 0.5f;
     modelSets[2].scale[2] = 0.5f;
 
-    // Initialize cloth settings
-    clothSettings.translation[1] = 6.0f;
-    clothSettings.scale[0] = 1.0f;
-    clothSettings.scale[1] = 1.0f;
-    clothSettings.scale[2] = 1.0f;
+    // Initialize cloth settings, side by side
+    this->nCloths = nCloths;
+    clothSets.resize(nCloths);
+    for (size_t i = 0; i < nCloths; i++)
+    {
+        clothSets[i].translation[0] = -7.0f * i;
+        clothSets[i].translation[1] = 6.0f;
+        clothSets[i].scale[0] = 1.0f;
+        clothSets[i].scale[1] = 1.0f;
+        clothSets[i].scale[2] = 1.0f;
+    }
 }
 
 void GUI::Render()
@@ -73,17 +81,59 @@ void GUI::Render()
     ImGui::Separator();
     ImGui::Text("Simulation settings");
     ImGui::SliderFloat("Speed", &m_sceneSettings.sim_speed, 0.01f, 1.0f, "%.2f");
+    ImGui::SliderInt("Steps per second", &m_sceneSettings.sim_rate, 15, 240);
+    ImGui::SliderInt("Max steps per frame", &m_sceneSettings.sim_max_steps, 1, 16);
+    ImGui::Checkbox("Interpolate", &m_sceneSettings.sim_interpolate);
+    ImGui::Text("Steps this frame: %d", m_sceneSettings.sim_steps);
     ImGui::SliderFloat("Drag amount", &m_sceneSettings.sim_drag_amount, 0.01f, 2.0f, "%.2f");
     ImGui::Checkbox("Drag on", &m_sceneSettings.sim_drag);
     ImGui::SliderFloat("Wind amount", &m_sceneSettings.sim_wind_amount, 0.01f, 2.0f, "%.2f");
     ImGui::Checkbox("Wind on", &m_sceneSettings.sim_wind);
+    const char* solverModes[] = { "Gauss-Seidel", "XPBD", "Multigrid", "Jacobi", "Implicit" };
+    int solverMode = static_cast<int>(m_sceneSettings.cloth_solver.solverMode);
+    if (ImGui::Combo("Solver", &solverMode, solverModes, IM_ARRAYSIZE(solverModes)))
+        m_sceneSettings.cloth_solver.solverMode = static_cast<ClothSolverMode>(solverMode);
+    ImGui::SliderInt("Substeps", &m_sceneSettings.cloth_solver.substeps, 1, 64);
+    ImGui::SliderInt("Constraint iterations", &m_sceneSettings.cloth_solver.constraintIterations, 1, 50);
+    ImGui::SliderFloat("Compliance", &m_sceneSettings.cloth_solver.compliance, 0.0f, 1e-3f, "%.2e", ImGuiSliderFlags_Logarithmic);
+    ImGui::SliderFloat("Chebyshev rho", &m_sceneSettings.cloth_solver.chebyshevRho, 0.0f, 0.99f, "%.2f");
+    ImGui::SliderFloat("Stretch stiffness", &m_sceneSettings.cloth_solver.stretchStiffness, 0.01f, 1000.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+    ImGui::SliderFloat("Shear stiffness", &m_sceneSettings.cloth_solver.shearStiffness, 0.01f, 1000.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+    ImGui::Checkbox("Tethers", &m_sceneSettings.cloth_solver.tethers);
+    ImGui::SliderFloat3("Gravity", glm::value_ptr(m_sceneSettings.cloth_solver.gravity), -0.01f, 0.01f, "%.4f");
+    ImGui::SliderFloat("Slack", &m_sceneSettings.cloth_solver.slack, 1.0f, 1.5f, "%.2f");
+    ImGui::SliderFloat("Tolerance", &m_sceneSettings.cloth_solver.tolerance, 0.0f, 0.01f, "%.4f");
+    ImGui::Text("Constraint iterations: %d / %d", m_sceneSettings.cloth_stats.iterations, m_sceneSettings.cloth_stats.maxIterations);
+    ImGui::Text("Constraint residual: %.5f", m_sceneSettings.cloth_stats.residual);
+    ImGui::Checkbox("Sleeping", &m_sceneSettings.cloth_solver.sleeping);
+    ImGui::SliderFloat("Sleep threshold", &m_sceneSettings.cloth_solver.sleepThreshold, 0.0f, 0.001f, "%.5f");
+    ImGui::SliderInt("Sleep frames", &m_sceneSettings.cloth_solver.sleepFrames, 1, 120);
+    ImGui::Text("Sleeping tiles: %d / %d", m_sceneSettings.cloth_stats.sleepingTiles, m_sceneSettings.cloth_stats.tiles);
+    ImGui::Checkbox("Self collision", &m_sceneSettings.cloth_solver.selfCollision);
+    ImGui::SliderFloat("Thickness", &m_sceneSettings.cloth_solver.thickness, 0.01f, 0.5f, "%.2f");
+    ImGui::Text("Self contacts: %d", m_sceneSettings.cloth_stats.selfContacts);
+    ImGui::SliderFloat("Collider margin", &m_sceneSettings.cloth_solver.colliderMargin, 0.0f, 0.5f, "%.2f");
+    ImGui::Checkbox("Continuous collision", &m_sceneSettings.cloth_solver.continuousCollision);
+    ImGui::Text("Swept contacts: %d", m_sceneSettings.cloth_stats.sweptContacts);
+    ImGui::Checkbox("Sphere collider", &m_sceneSettings.sim_sphere);
+    ImGui::SliderFloat3("Sphere position", m_sceneSettings.sim_sphere_position, -10.0f, 10.0f);
+    ImGui::SliderFloat("Sphere radius", &m_sceneSettings.sim_sphere_radius, 0.1f, 5.0f, "%.2f");
+    ImGui::Checkbox("Floor collider", &m_sceneSettings.sim_floor);
+    ImGui::SliderFloat("Floor height", &m_sceneSettings.sim_floor_height, -10.0f, 10.0f, "%.2f");
+    ImGui::Checkbox("Model distance fields", &m_sceneSettings.sim_model_sdf);
+    ImGui::Checkbox("Cloth collision", &m_sceneSettings.cloth_solver.clothCollision);
+    ImGui::Text("Cloth contacts: %d", m_sceneSettings.cloth_stats.clothContacts);
+    ImGui::Text("Cloth BVH refits: %d, rebuilds: %d", m_sceneSettings.cloth_stats.bvhRefits, m_sceneSettings.cloth_stats.bvhRebuilds);
     ImGui::Checkbox("Play", &m_sceneSettings.run_sim);
-    std::string strEnabled = std::string("Cloth enabled");
-    std::string strTranslation = std::string("Cloth translation");
-    std::string strScale = std::string("Cloth scaling");
-    ImGui::Checkbox(strEnabled.c_str(), &clothSettings.enabled);
-    ImGui::SliderFloat3(strTranslation.c_str(), clothSettings.translation, -10.0f, 10.0f);
-    ImGui::SliderFloat3(strScale.c_str(), clothSettings.scale, 0.001f, 2.0f);
+    for (size_t i = 0; i < nCloths; i++)
+    {
+        const std::string strEnabled = std::string("Cloth ") + std::to_string(i) + " enabled";
+        const std::string strTranslation = std::string("Cloth ") + std::to_string(i) + " translation";
+        const std::string strScale = std::string("Cloth ") + std::to_string(i) + " scaling";
+        ImGui::Checkbox(strEnabled.c_str(), &clothSets[i].enabled);
+        ImGui::SliderFloat3(strTranslation.c_str(), clothSets[i].translation, -10.0f, 10.0f);
+        ImGui::SliderFloat3(strScale.c_str(), clothSets[i].scale, 0.001f, 2.0f);
+    }
 
     ImGui::Separator();
     ImGui::Text("Models");
@@ -97,9 +147,9 @@ void GUI::Render()
         ImGui::SliderFloat3(strScale.c_str(), modelSets[i].scale, 0.001f, 2.0f);
     }
     ImGui::Separator();
-    strEnabled = std::string("Custom Model enabled");
-    strTranslation = std::string("Custom Model translation");
-    strScale = std::string("Custom Model scaling");
+    const std::string strEnabled = std::string("Custom Model enabled");
+    const std::string strTranslation = std::string("Custom Model translation");
+    const std::string strScale = std::string("Custom Model scaling");
     ImGui::Checkbox(strEnabled.c_str(), &customModelSettings.enabled);
     ImGui::SliderFloat3(strTranslation.c_str(), customModelSettings.translation, -10.0f, 10.0f);
     ImGui::SliderFloat3(strScale.c_str(), customModelSettings.scale, 0.001f, 2.0f);
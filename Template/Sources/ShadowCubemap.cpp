@@ -37,7 +37,7 @@ ShadowCubemap::~ShadowCubemap()
 {}
 
 void ShadowCubemap::Render(float* lightPos, std::vector<Model>& models, const int nModels, GUI& gui, CustomModel* customModel,
-    ClothMesh* clothMesh)
+    std::vector<std::unique_ptr<ClothMesh>>* cloths)
 {
     // Switch to proper viewport and bind framebuffer
     //glCullFace(GL_FRONT);
@@ -63,8 +63,10 @@ void ShadowCubemap::Render(float* lightPos, std::vector<Model>& models, const in
         customModel->Render(shader, glm::mat4(1.0f));
     }
 
-    if (clothMesh != nullptr && gui.clothSettings.enabled)
-        clothMesh->Render(shader, gui.clothSettings.GetModelMatrix());
+    if (cloths != nullptr)
+        for (size_t i = 0; i < cloths->size(); i++)
+            if (gui.clothSets[i].enabled)
+                (*cloths)[i]->Render(shader, gui.clothSets[i].GetModelMatrix());
 
     //glCullFace(GL_BACK);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
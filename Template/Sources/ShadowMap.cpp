@@ -32,7 +32,7 @@ ShadowMap::~ShadowMap()
 {}
 
 void ShadowMap::Render(float* lightPos, glm::mat4& lightProjection, std::vector<Model>& models, const int nModels, GUI& gui,
-    CustomModel* customModel, ClothMesh* clothMesh)
+    CustomModel* customModel, std::vector<std::unique_ptr<ClothMesh>>* cloths)
 {
     // Render to depth map
     glCullFace(GL_FRONT);
@@ -53,8 +53,10 @@ void ShadowMap::Render(float* lightPos, glm::mat4& lightProjection, std::vector<
         customModel->Render(shader, glm::mat4(1.0f));
     }
 
-    if (clothMesh != nullptr && gui.clothSettings.enabled)
-        clothMesh->Render(shader, gui.clothSettings.GetModelMatrix());
+    if (cloths != nullptr)
+        for (size_t i = 0; i < cloths->size(); i++)
+            if (gui.clothSets[i].enabled)
+                (*cloths)[i]->Render(shader, gui.clothSets[i].GetModelMatrix());
 
     glCullFace(GL_BACK);
 }
@@ -9,6 +9,8 @@
 #include <ShadowCubemap.hpp>
 #include <CustomModel.hpp>
 #include <ClothMesh.hpp>
+#include <ClothWorld.hpp>
+#include <ClothSimThread.hpp>
 #include <Tests.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -154,6 +156,12 @@ int main(int argc, char * argv[]) {
     customFragChar += "\\..\\Template\\Shaders\\customModelShader.frag";
     Shader customModelShader(customVertChar.c_str(), customFragChar.c_str());
 
+    std::string clothVertChar(buffer);
+    std::string clothFragChar(buffer);
+    clothVertChar += "\\..\\Template\\Shaders\\clothShader.vert";
+    clothFragChar += "\\..\\Template\\Shaders\\clothShader.frag";
+    Shader clothShader(clothVertChar.c_str(), clothFragChar.c_str());
+
     std::string sky_vs_char(buffer);
     std::string sky_fs_char(buffer);
     sky_vs_char += "\\..\\Template\\Shaders\\skybox.vert";
@@ -292,9 +300,19 @@ int main(int argc, char * argv[]) {
     skyChar += "\\..\\textures\\Yokohama3\\";
     Skybox sky(skyChar, skyShader);
 
+    // Cloth meshes of different resolutions, simulated together by the cloth world
+    ClothWorld clothWorld;
+    std::vector<std::unique_ptr<ClothMesh>> cloths;
+    cloths.emplace_back(new ClothMesh(clothWorld.AddCloth(5.0f, 5.0f, 8, 8, 16, 2.0f, settings.cloth_solver), "clothFabric.png"));
+    cloths.emplace_back(new ClothMesh(clothWorld.AddCloth(5.0f, 5.0f, 24, 24, 24, 2.0f, settings.cloth_solver), "clothPineapple.png"));
+    cloths.emplace_back(new ClothMesh(clothWorld.AddCloth(5.0f, 5.0f, 32, 32, 32, 2.0f, settings.cloth_solver), "clothTexture.jpg"));
+
+    // Simulates the next frame while the last one is drawn
+    ClothSimThread simThread(clothWorld);
+
     GUI gui(mWindow, cam, settings, timer);
     guiPointer = &gui;
-    gui.Init(nModels);
+    gui.Init(nModels, cloths.size());
 
     // Shadow maps
     ShadowMap shadow(shadowShader, quadShader, 2048, 2048, mWidth, mHeight);
@@ -324,15 +342,23 @@ int main(int argc, char * argv[]) {
     // Custom model
     CustomModel testCustom(customDebug);
 
-    // Cloth mesh
-    //ClothMesh cloth(5.0f, 5.0f, 8, 8, 16, "clothPineapple.png");
-    ClothMesh cloth(5.0f, 5.0f, 8, 8, 16, "clothFabric.png");
-
     // Seed RNGs
     srand(static_cast <unsigned> (time(0)));
 
     // Test sphere intersections
-    //SphereIntersectionTesting();
+    //ColliderKernelTesting();
+
+    // Test SIMD integration kernels against the scalar path
+    //IntegrationKernelTesting();
+
+    // Test the SIMD Jacobi sweep against the scalar path
+    //JacobiKernelTesting();
+
+    // Test the SIMD conjugate gradient vector operations against the scalar path
+    //ConjugateGradientKernelTesting();
+
+    // Test that a stretched link is projected back to its rest length without overshooting
+    //LinkProjectionTest();
 
     //return true;
 
@@ -358,10 +384,10 @@ int main(int argc, char * argv[]) {
 
         // Render to depth map
         shadow.Render(settings.light_position, glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, shadow.nearPlane, shadow.farPlane), models, nModels, gui,
-            &testCustom, &cloth);
+            &testCustom, &cloths);
 
         // Render to omnidirectional depth map
-        shadowCubemap.Render(settings.point_light_position, models, nModels, gui, &testCustom, &cloth);
+        shadowCubemap.Render(settings.point_light_position, models, nModels, gui, &testCustom, &cloths);
 
         // Switch to regular framebuffer
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -395,12 +421,61 @@ int main(int argc, char * argv[]) {
         // Render cloth
         if (settings.run_sim)
         {
-            cloth.Simulate(settings.sim_wind, settings.sim_wind_amount, settings.sim_drag, settings.sim_drag_amount,
-                gui.clothSettings.GetModelMatrix(), static_cast<float>(timer.GetData().DeltaTime) * settings.sim_speed);
-            cloth.UpdateVertices(currentFrame);
+            // Pick up the frame simulated while the last one was drawn. The world is ours until the next job is submitted
+            const ClothSimFrame& frame = simThread.Sync();
+            settings.sim_steps = frame.steps;
+            settings.cloth_stats = frame.stats;
+            for (size_t i = 0; i < frame.positions.size(); i++)
+                cloths[i]->UpdateVertices(frame.positions[i], frame.normals[i]);
+
+            ClothSimJob job;
+            if (settings.sim_drag)
+                job.forceFields.push_back(ForceField::Drag(settings.sim_drag_amount));
+            if (settings.sim_wind)
+                job.forceFields.push_back(ForceField::Wind(settings.sim_wind_amount));
+
+            // Enabled scene models are static colliders. Their distance fields only hold up under uniform scaling
+            for (size_t i = 0; i < nModels; i++)
+            {
+                if (!gui.modelSets[i].enabled)
+                    continue;
+
+                const float* scale = gui.modelSets[i].scale;
+                if (settings.sim_model_sdf && !models[i].sdf.IsEmpty() && scale[0] == scale[1] && scale[1] == scale[2])
+                    job.colliders.sdfs.push_back({ &models[i].sdf, gui.modelSets[i].GetModelMatrix() });
+                else
+                    for (size_t m = 0; m < models[i].meshes.size(); m++)
+                        job.colliders.meshes.push_back({ &models[i].meshes[m].bvh, gui.modelSets[i].GetModelMatrix() });
+            }
+
+            if (settings.sim_sphere)
+                job.colliders.spheres.push_back({ glm::make_vec3(settings.sim_sphere_position), settings.sim_sphere_radius });
+            if (settings.sim_floor)
+                job.colliders.planes.push_back({ glm::vec3(0.0f, 1.0f, 0.0f), settings.sim_floor_height });
+
+            for (size_t i = 0; i < cloths.size(); i++)
+            {
+                cloths[i]->solver.settings = settings.cloth_solver;
+                job.modelMatrices.push_back(gui.clothSets[i].GetModelMatrix());
+            }
+
+            // Fixed steps, so the cloth behaves the same at any frame rate. Speed stretches time rather than the step
+            job.frameTime = static_cast<float>(timer.GetData().DeltaTime) * settings.sim_speed;
+            job.rate = static_cast<float>(settings.sim_rate);
+            job.maxSteps = settings.sim_max_steps;
+            job.interpolate = settings.sim_interpolate;
+            simThread.Submit(job);
         }
-        if (gui.clothSettings.enabled)
-            cloth.Render(customModelShader, gui.clothSettings.GetModelMatrix());
+        clothShader.use();
+        clothShader.setMat4("projection", projection);
+        clothShader.setMat4("view", view);
+        clothShader.setVec3("viewPos", cam.position);
+        clothShader.setVec3("lightPos", glm::vec3(settings.light_position[0], settings.light_position[1], settings.light_position[2]));
+        clothShader.setVec3("pointLightPos", glm::vec3(settings.point_light_position[0], settings.point_light_position[1], settings.point_light_position[2]));
+        clothShader.setVec3("lightColor", glm::vec3(settings.light_color[0], settings.light_color[1], settings.light_color[2]));
+        for (size_t i = 0; i < cloths.size(); i++)
+            if (gui.clothSets[i].enabled)
+                cloths[i]->Render(clothShader, gui.clothSets[i].GetModelMatrix());
 
         lightingShader.use();
         lightingShader.setMat4("projection", projection);